@@ -0,0 +1,349 @@
+#ifndef AUTOLABA_ALIGNSIMD_H
+#define AUTOLABA_ALIGNSIMD_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "AminoAcids.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AUTOLABA_SIMD_X86 1
+#endif
+
+/*
+ * Score глобального выравнивания (та же рекурсия и те же границы, что в DP()) векторами по int16 - схема Фаррара:
+ * вторая последовательность раскладывается "полосами": в векторе t лежат столбцы t, t + seg, t + 2 seg, ...
+ * (seg = длина / число полос), поэтому зависимость по строке DP почти вся оказывается между соседними векторами.
+ * Недостающий перенос из конца одной полосы в начало следующей досчитывается ленивым циклом, который обычно
+ * останавливается через пару векторов. Значения замен для каждой буквы заранее разложены так же (профиль запроса).
+ * Сложение с насыщением; если значения подходят к границам int16, счет повторяется скалярно - ответ всегда точный.
+ * Набор команд (SSE4.1, AVX2, AVX-512) выбирается при запуске по процессору, см. DefaultSimd().
+ */
+
+enum class SimdLevel {
+    SCALAR,
+    SSE41,
+    AVX2,
+    AVX512
+};
+
+inline const char* SimdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::SSE41: return "sse4.1";
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::AVX512: return "avx512";
+        default: return "scalar";
+    }
+}
+
+// старший набор команд этого процессора (определяется один раз)
+inline SimdLevel AvailableSimd() {
+#ifdef AUTOLABA_SIMD_X86
+    static const SimdLevel level = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) return SimdLevel::AVX512;
+        if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+        if (__builtin_cpu_supports("sse4.1")) return SimdLevel::SSE41;
+        return SimdLevel::SCALAR;
+    }();
+    return level;
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+// набор команд по умолчанию: не выше AVX2 - на замерах (--bench-align) AVX-512 на белках обычной длины медленнее;
+// переменная окружения AUTOLABA_SIMD (scalar, sse4.1, avx2, avx512) задает набор явно
+inline SimdLevel DefaultSimd() {
+    static const SimdLevel level = [] {
+        const SimdLevel available = AvailableSimd();
+        const char* name = std::getenv("AUTOLABA_SIMD");
+        if (name == nullptr || *name == '\0') return std::min(available, SimdLevel::AVX2);
+        for (SimdLevel candidate : {SimdLevel::SCALAR, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::AVX512}) {
+            if (std::string_view(name) != SimdLevelName(candidate)) continue;
+            if (candidate > available) {
+                throw std::runtime_error(std::string("AUTOLABA_SIMD: ") + name + " is not supported by this processor");
+            }
+            return candidate;
+        }
+        throw std::runtime_error(std::string("AUTOLABA_SIMD: unknown instruction set '") + name + "'");
+    }();
+    return level;
+}
+
+// память, которая переиспользуется между вызовами: профиль запроса, две строки DP, коды последовательностей
+struct StripedWorkspace {
+    std::vector<std::int16_t> profile;
+    std::vector<std::int16_t> rows;
+    AlignWorkspace scalar;
+};
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi" // векторы AVX внутри общего ядра, которое встраивается в функции с нужной целью
+#endif
+
+namespace AlignSimdDetail {
+
+inline constexpr std::int16_t Negative = std::numeric_limits<std::int16_t>::min();
+// пока все значения строки внутри [Low, High], ни одно сложение следующей строки не упирается в насыщение
+inline constexpr int High = std::numeric_limits<std::int16_t>::max() - 128;
+inline constexpr int Low = std::numeric_limits<std::int16_t>::min() + 256;
+
+struct StripedArgs {
+    const std::uint8_t* a;        // первая последовательность (строки DP)
+    int n;
+    const std::int16_t* profile;  // [код][вектор][полоса]
+    int segments;                 // векторов в строке
+    int m;                        // длина второй последовательности (столбцы DP)
+    std::int16_t* load;           // две строки по segments * lanes
+    std::int16_t* store;
+};
+
+// один проход по строкам; false - значения вышли к границам int16
+template <class V>
+inline bool StripedKernel(const StripedArgs& args, int& score) {
+    using Vec = typename V::Vec;
+    constexpr int L = V::Lanes;
+    const int seg = args.segments;
+    std::int16_t* load = args.load;
+    std::int16_t* store = args.store;
+    const auto g = static_cast<std::int16_t>(gap);
+    const Vec vGap = V::Set1(g);
+    const Vec vHigh = V::Set1(static_cast<std::int16_t>(High));
+    const Vec vLow = V::Set1(static_cast<std::int16_t>(Low));
+    Vec vMax = V::Set1(0);
+    Vec vMin = V::Set1(0);
+
+    // строка 0: dp[0][j] = gap
+    for (int k = 0; k < seg * L; ++k) load[k] = g;
+    for (int i = 1; i <= args.n; ++i) {
+        const std::int16_t* profile = args.profile + static_cast<std::size_t>(args.a[i - 1]) * seg * L;
+        // диагональ для t = 0: значения из конца предыдущих полос, в полосу 0 - dp[i - 1][0]
+        Vec vDiagonal = V::ShiftInsert(V::Load(load + (seg - 1) * L), i == 1 ? 0 : g);
+        // перенос по строке в столбец 1 из dp[i][0] = gap; в остальные полосы - ленивым циклом
+        Vec vF = V::ShiftInsert(V::Set1(Negative), static_cast<std::int16_t>(2 * g));
+        for (int t = 0; t < seg; ++t) {
+            const Vec vUp = V::Load(load + t * L);
+            Vec vH = V::Adds(vDiagonal, V::Load(profile + t * L));
+            vH = V::Max(vH, V::Adds(vUp, vGap));
+            vH = V::Max(vH, vF);
+            V::Store(store + t * L, vH);
+            vMax = V::Max(vMax, vH);
+            vMin = V::Min(vMin, vH);
+            vF = V::Adds(vH, vGap);
+            vDiagonal = vUp;
+        }
+        // ленивый цикл: перенос из конца полосы l в начало полосы l + 1, пока он что-то улучшает
+        vF = V::ShiftInsert(vF, Negative);
+        for (int t = 0; V::AnyGreater(vF, V::Load(store + t * L));) {
+            const Vec vH = V::Max(V::Load(store + t * L), vF);
+            V::Store(store + t * L, vH);
+            vMax = V::Max(vMax, vH);
+            vF = V::Adds(vF, vGap);
+            if (++t == seg) {
+                t = 0;
+                vF = V::ShiftInsert(vF, Negative);
+            }
+        }
+        if (V::AnyGreater(vMax, vHigh) || V::AnyGreater(vLow, vMin)) return false;
+        std::swap(load, store);
+    }
+    const int column = args.m - 1;
+    score = load[(column % seg) * L + column / seg];
+    return true;
+}
+
+#ifdef AUTOLABA_SIMD_X86
+
+struct Sse41Lanes {
+    using Vec = __m128i;
+    static constexpr int Lanes = 8;
+    [[gnu::target("sse4.1")]] static Vec Load(const std::int16_t* p) { return _mm_loadu_si128(reinterpret_cast<const Vec*>(p)); }
+    [[gnu::target("sse4.1")]] static void Store(std::int16_t* p, Vec v) { _mm_storeu_si128(reinterpret_cast<Vec*>(p), v); }
+    [[gnu::target("sse4.1")]] static Vec Set1(std::int16_t x) { return _mm_set1_epi16(x); }
+    [[gnu::target("sse4.1")]] static Vec Adds(Vec a, Vec b) { return _mm_adds_epi16(a, b); }
+    [[gnu::target("sse4.1")]] static Vec Max(Vec a, Vec b) { return _mm_max_epi16(a, b); }
+    [[gnu::target("sse4.1")]] static Vec Min(Vec a, Vec b) { return _mm_min_epi16(a, b); }
+    // сдвиг на полосу вверх, в полосу 0 - x
+    [[gnu::target("sse4.1")]] static Vec ShiftInsert(Vec v, std::int16_t x) { return _mm_insert_epi16(_mm_slli_si128(v, 2), x, 0); }
+    [[gnu::target("sse4.1")]] static bool AnyGreater(Vec a, Vec b) { return !_mm_testz_si128(_mm_cmpgt_epi16(a, b), _mm_set1_epi16(-1)); }
+};
+
+struct Avx2Lanes {
+    using Vec = __m256i;
+    static constexpr int Lanes = 16;
+    [[gnu::target("avx2")]] static Vec Load(const std::int16_t* p) { return _mm256_loadu_si256(reinterpret_cast<const Vec*>(p)); }
+    [[gnu::target("avx2")]] static void Store(std::int16_t* p, Vec v) { _mm256_storeu_si256(reinterpret_cast<Vec*>(p), v); }
+    [[gnu::target("avx2")]] static Vec Set1(std::int16_t x) { return _mm256_set1_epi16(x); }
+    [[gnu::target("avx2")]] static Vec Adds(Vec a, Vec b) { return _mm256_adds_epi16(a, b); }
+    [[gnu::target("avx2")]] static Vec Max(Vec a, Vec b) { return _mm256_max_epi16(a, b); }
+    [[gnu::target("avx2")]] static Vec Min(Vec a, Vec b) { return _mm256_min_epi16(a, b); }
+    // сдвиг через границу 128-битных половин: младшая половина v переезжает в старшую
+    [[gnu::target("avx2")]] static Vec ShiftInsert(Vec v, std::int16_t x) {
+        const Vec shifted = _mm256_alignr_epi8(v, _mm256_permute2x128_si256(v, v, 0x08), 14);
+        return _mm256_insert_epi16(shifted, x, 0);
+    }
+    [[gnu::target("avx2")]] static bool AnyGreater(Vec a, Vec b) { return _mm256_movemask_epi8(_mm256_cmpgt_epi16(a, b)) != 0; }
+};
+
+struct Avx512Lanes {
+    using Vec = __m512i;
+    static constexpr int Lanes = 32;
+    [[gnu::target("avx512f,avx512bw")]] static Vec Load(const std::int16_t* p) { return _mm512_loadu_si512(p); }
+    [[gnu::target("avx512f,avx512bw")]] static void Store(std::int16_t* p, Vec v) { _mm512_storeu_si512(p, v); }
+    [[gnu::target("avx512f,avx512bw")]] static Vec Set1(std::int16_t x) { return _mm512_set1_epi16(x); }
+    [[gnu::target("avx512f,avx512bw")]] static Vec Adds(Vec a, Vec b) { return _mm512_adds_epi16(a, b); }
+    [[gnu::target("avx512f,avx512bw")]] static Vec Max(Vec a, Vec b) { return _mm512_max_epi16(a, b); }
+    [[gnu::target("avx512f,avx512bw")]] static Vec Min(Vec a, Vec b) { return _mm512_min_epi16(a, b); }
+    [[gnu::target("avx512f,avx512bw")]] static Vec ShiftInsert(Vec v, std::int16_t x) {
+        static constexpr std::int16_t previous[32] = {0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+                                                      15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30};
+        return _mm512_mask_set1_epi16(_mm512_permutexvar_epi16(_mm512_loadu_si512(previous), v), 1, x);
+    }
+    [[gnu::target("avx512f,avx512bw")]] static bool AnyGreater(Vec a, Vec b) { return _mm512_cmpgt_epi16_mask(a, b) != 0; }
+};
+
+// обертки с нужной целью: flatten встраивает в них ядро вместе с командами набора
+[[gnu::target("sse4.1"), gnu::flatten]] inline bool StripedSse41(const StripedArgs& args, int& score) {
+    return StripedKernel<Sse41Lanes>(args, score);
+}
+[[gnu::target("avx2"), gnu::flatten]] inline bool StripedAvx2(const StripedArgs& args, int& score) {
+    return StripedKernel<Avx2Lanes>(args, score);
+}
+[[gnu::target("avx512f,avx512bw"), gnu::flatten]] inline bool StripedAvx512(const StripedArgs& args, int& score) {
+    return StripedKernel<Avx512Lanes>(args, score);
+}
+
+#endif // AUTOLABA_SIMD_X86
+
+inline int Lanes(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::SSE41: return 8;
+        case SimdLevel::AVX2: return 16;
+        case SimdLevel::AVX512: return 32;
+        default: return 1;
+    }
+}
+
+// профиль запроса: для каждой буквы таблицы значения замен со столбцами b, разложенные полосами; хвост - нули
+inline void BuildProfile(const std::uint8_t* b, int m, int lanes, int segments, std::vector<std::int16_t>& profile) {
+    const int letters = Substitution.size;
+    profile.resize(static_cast<std::size_t>(letters) * segments * lanes);
+    for (int r = 0; r < letters; ++r) {
+        const std::int8_t* row = Substitution.Row(static_cast<std::uint8_t>(r));
+        std::int16_t* out = profile.data() + static_cast<std::size_t>(r) * segments * lanes;
+        for (int t = 0; t < segments; ++t) {
+            for (int l = 0; l < lanes; ++l) {
+                const int j = l * segments + t;
+                out[t * lanes + l] = j < m ? row[b[j]] : 0;
+            }
+        }
+    }
+}
+
+} // namespace AlignSimdDetail
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// то же, что ScoreEncoded, векторами выбранного набора команд
+inline int ScoreSimd(const std::uint8_t* a, std::size_t n, const std::uint8_t* b, std::size_t m, StripedWorkspace& workspace,
+                     SimdLevel level = DefaultSimd()) {
+    using namespace AlignSimdDetail;
+    const bool fits = n > 0 && m > 0 && n < (1u << 30) && m < (1u << 30) && gap <= 0 && gap >= -127;
+#ifdef AUTOLABA_SIMD_X86
+    if (fits && level != SimdLevel::SCALAR) {
+        const int lanes = Lanes(level);
+        const int segments = static_cast<int>((m + lanes - 1) / lanes);
+        BuildProfile(b, static_cast<int>(m), lanes, segments, workspace.profile);
+        workspace.rows.resize(static_cast<std::size_t>(2) * segments * lanes);
+        const StripedArgs args {a, static_cast<int>(n), workspace.profile.data(), segments, static_cast<int>(m),
+                                workspace.rows.data(), workspace.rows.data() + static_cast<std::size_t>(segments) * lanes};
+        int score = 0;
+        const bool done = level == SimdLevel::AVX512 ? StripedAvx512(args, score)
+                        : level == SimdLevel::AVX2   ? StripedAvx2(args, score)
+                                                     : StripedSse41(args, score);
+        if (done) return score;
+    }
+#endif
+    (void) fits;
+    return ScoreEncoded(a, n, b, m, workspace.scalar.row);
+}
+
+// score пары последовательностей через векторное ядро; память своя у каждого потока
+inline int ScoreSequences(std::string_view seq1, std::string_view seq2, SimdLevel level = DefaultSimd()) {
+    thread_local StripedWorkspace workspace;
+    EncodeSequence(seq1, workspace.scalar.first);
+    EncodeSequence(seq2, workspace.scalar.second);
+    return ScoreSimd(workspace.scalar.first.data(), workspace.scalar.first.size(), workspace.scalar.second.data(),
+                     workspace.scalar.second.size(), workspace, level);
+}
+
+// замер ядер на случайных белках: миллиарды клеток DP в секунду (GCUPS) для каждого доступного набора команд;
+// ответы векторных ядер сверяются со скалярным, при расхождении - false
+inline bool BenchmarkAlignment(std::ostream& out) {
+    const SimdLevel chosen = DefaultSimd();
+    std::vector<SimdLevel> levels {SimdLevel::SCALAR};
+    for (SimdLevel level : {SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (level <= AvailableSimd()) levels.push_back(level);
+    }
+    std::mt19937 rng(12345);
+    std::string letters;
+    for (int k = 0; k < Substitution.size; ++k) letters += Substitution.letters[k];
+    auto random = [&](int length) {
+        std::vector<std::uint8_t> codes(length);
+        for (auto& c : codes) c = static_cast<std::uint8_t>(ResidueCode(letters[rng() % letters.size()]));
+        return codes;
+    };
+
+    out << "length";
+    for (SimdLevel level : levels) out << '\t' << SimdLevelName(level);
+    out << "\t(GCUPS, default: " << SimdLevelName(chosen) << ")\n";
+    bool ok = true;
+    StripedWorkspace workspace;
+    for (int length : {100, 300, 1000, 3000}) {
+        // пары похожих белков: вторая - копия первой с заменами, как у концов ребер диаграммы
+        std::vector<std::vector<std::uint8_t>> first, second;
+        for (int k = 0; k < std::max(4, 2000000 / (length * length)); ++k) {
+            first.push_back(random(length));
+            second.push_back(first.back());
+            for (int e = 0; e < length / 5; ++e) second.back()[rng() % length] = random(1)[0];
+        }
+        std::vector<int> reference;
+        out << length;
+        for (SimdLevel level : levels) {
+            std::vector<int> scores;
+            double cells = 0.0;
+            const auto start = std::chrono::steady_clock::now();
+            double seconds = 0.0;
+            do {
+                scores.clear();
+                for (std::size_t k = 0; k < first.size(); ++k) {
+                    scores.push_back(ScoreSimd(first[k].data(), first[k].size(), second[k].data(), second[k].size(), workspace, level));
+                    cells += static_cast<double>(first[k].size()) * static_cast<double>(second[k].size());
+                }
+                seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            } while (seconds < 0.2);
+            if (reference.empty()) reference = scores;
+            if (scores != reference) ok = false;
+            out << '\t' << cells / seconds / 1e9;
+        }
+        out << '\n';
+    }
+    if (!ok) out << "MISMATCH: vector kernels disagree with the scalar one\n";
+    return ok;
+}
+
+#endif //AUTOLABA_ALIGNSIMD_H
@@ -0,0 +1,234 @@
+#ifndef AUTOLABA_ALIGNMENT_H
+#define AUTOLABA_ALIGNMENT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "AlignSimd.h"
+#include "AminoAcids.h"
+#include "ElementFile.h"
+#include "HasseBuilder.h"
+#include "Parallel.h"
+
+// выравнивание концов ребра: считается один раз после построения диаграммы, окно и экспорт только читают
+struct EdgeAlignment {
+    int score = 0;
+    std::string first;       // выровненные последовательности, '-' на месте пропуска
+    std::string second;
+    double identity = 0.0;   // доля столбцов выравнивания с одинаковыми аминокислотами
+};
+
+/*
+ * Выравнивание в линейной памяти (по схеме Хиршберга) с тем же ответом, что traceBack(DP(...)).
+ * Кусок - прямоугольник строк [r0, r1] и столбцов [c0, c1], путь восстановления проходит через оба его угла;
+ * известны значения DP на верхней строке и левом столбце куска, остальные считаются от них.
+ * Деление: прямой проход до средней строки mid, дальше проход до r1, в котором каждая клетка помнит, в какой
+ * столбец строки mid приведет из нее восстановление (с теми же приоритетами: диагональ, вверх, влево).
+ * Из (r1, c1) это столбец j*, и путь распадается на куски (r0, c0)-(mid, j*) и (mid, j*)-(r1, c1), независимые
+ * друг от друга. Маленькие куски восстанавливаются по полной матрице, как в traceBack.
+ */
+namespace AlignDetail {
+
+inline constexpr long long FullMatrixCells = 1 << 18; // кусок не больше этого решается полной матрицей (1 МБ)
+
+struct Piece {
+    int r0 = 0, c0 = 0, r1 = 0, c1 = 0;
+    std::vector<int> top;  // dp[r0][c0..c1]
+    std::vector<int> left; // dp[r0..r1][c0]
+};
+
+struct PieceResult {
+    std::string first;  // выравнивание участка пути, слева направо
+    std::string second;
+    int score = 0;      // dp[r1][c1]
+};
+
+class LinearAligner {
+private:
+    std::string_view seq1_;
+    std::string_view seq2_;
+    std::vector<std::uint8_t> a_;
+    std::vector<std::uint8_t> b_;
+
+    int Pair(int i, int j) const { return Substitution.Score(a_[i - 1], b_[j - 1]); }
+
+    // строка row (значения dp[from][c0..c1]) продвигается до строки to
+    void Advance(const Piece& piece, std::vector<int>& row, int from, int to, int c1) const {
+        for (int i = from + 1; i <= to; ++i) {
+            const std::int8_t* substitution = Substitution.Row(a_[i - 1]);
+            int diagonal = row[0];
+            row[0] = piece.left[i - piece.r0];
+            for (int j = piece.c0 + 1, k = 1; j <= c1; ++j, ++k) {
+                const int up = row[k];
+                row[k] = std::max(diagonal + substitution[b_[j - 1]], std::max(up + gap, row[k - 1] + gap));
+                diagonal = up;
+            }
+        }
+    }
+
+    // восстановление по полной матрице куска; на верхней строке путь идет влево, на левом столбце - вверх
+    PieceResult Full(const Piece& piece) const {
+        const int h = piece.r1 - piece.r0, w = piece.c1 - piece.c0;
+        std::vector<int> dp(static_cast<std::size_t>(h + 1) * (w + 1));
+        auto at = [&](int i, int j) -> int& { return dp[static_cast<std::size_t>(i) * (w + 1) + j]; };
+        for (int j = 0; j <= w; ++j) at(0, j) = piece.top[j];
+        for (int i = 1; i <= h; ++i) {
+            at(i, 0) = piece.left[i];
+            for (int j = 1; j <= w; ++j) {
+                at(i, j) = std::max(at(i - 1, j - 1) + Pair(piece.r0 + i, piece.c0 + j),
+                                    std::max(at(i - 1, j) + gap, at(i, j - 1) + gap));
+            }
+        }
+        PieceResult result;
+        result.score = at(h, w);
+        int i = h, j = w;
+        while (i > 0 || j > 0) {
+            const int si = piece.r0 + i, sj = piece.c0 + j;
+            if (i > 0 && j > 0 && at(i, j) == at(i - 1, j - 1) + Pair(si, sj)) {
+                result.first += seq1_[si - 1];
+                result.second += seq2_[sj - 1];
+                --i;
+                --j;
+            } else if (i > 0 && (j == 0 || at(i, j) == at(i - 1, j) + gap)) {
+                result.first += seq1_[si - 1];
+                result.second += '-';
+                --i;
+            } else {
+                result.first += '-';
+                result.second += seq2_[sj - 1];
+                --j;
+            }
+        }
+        std::reverse(result.first.begin(), result.first.end());
+        std::reverse(result.second.begin(), result.second.end());
+        return result;
+    }
+
+public:
+    LinearAligner(std::string_view seq1, std::string_view seq2) : seq1_(seq1), seq2_(seq2) {
+        EncodeSequence(seq1, a_);
+        EncodeSequence(seq2, b_);
+    }
+
+    PieceResult Solve(const Piece& piece, int threads) const {
+        const int h = piece.r1 - piece.r0, w = piece.c1 - piece.c0;
+        if (h < 2 || static_cast<long long>(h) * w <= FullMatrixCells) return Full(piece);
+        const int mid = piece.r0 + h / 2;
+
+        // прямой проход до строки mid
+        std::vector<int> row(piece.top);
+        Advance(piece, row, piece.r0, mid, piece.c1);
+        const std::vector<int> middle(row);
+
+        // от mid до r1: origin[k] - столбец строки mid, куда восстановление приходит из клетки (i, c0 + k)
+        std::vector<int> origin(w + 1);
+        for (int k = 0; k <= w; ++k) origin[k] = k;
+        int score = 0;
+        for (int i = mid + 1; i <= piece.r1; ++i) {
+            const std::int8_t* substitution = Substitution.Row(a_[i - 1]);
+            int diagonal = row[0], diagonalOrigin = origin[0];
+            row[0] = piece.left[i - piece.r0];
+            origin[0] = 0; // левый столбец куска: путь по нему идет вверх
+            for (int k = 1; k <= w; ++k) {
+                const int up = row[k], upOrigin = origin[k];
+                const int value = std::max(diagonal + substitution[b_[piece.c0 + k - 1]], std::max(up + gap, row[k - 1] + gap));
+                if (value == diagonal + substitution[b_[piece.c0 + k - 1]]) origin[k] = diagonalOrigin;
+                else if (value != up + gap) origin[k] = origin[k - 1];
+                row[k] = value;
+                diagonal = up;
+                diagonalOrigin = upOrigin;
+            }
+        }
+        score = row[w];
+        const int split = origin[w]; // j* - c0
+
+        Piece upper {piece.r0, piece.c0, mid, piece.c0 + split,
+                     std::vector<int>(piece.top.begin(), piece.top.begin() + split + 1),
+                     std::vector<int>(piece.left.begin(), piece.left.begin() + (mid - piece.r0) + 1)};
+        // левый столбец нижнего куска - значения dp в столбце j*: еще один проход по строкам mid..r1 до j*
+        Piece lower {mid, piece.c0 + split, piece.r1, piece.c1,
+                     std::vector<int>(middle.begin() + split, middle.end()), {}};
+        lower.left.reserve(piece.r1 - mid + 1);
+        row.assign(middle.begin(), middle.begin() + split + 1);
+        lower.left.push_back(row[split]);
+        for (int i = mid + 1; i <= piece.r1; ++i) {
+            Advance(piece, row, i - 1, i, piece.c0 + split);
+            lower.left.push_back(row[split]);
+        }
+        row = {};
+        origin = {};
+
+        PieceResult halves[2];
+        ParallelFor(0, 2, std::min(threads, 2), [&](int k) {
+            halves[k] = Solve(k == 0 ? upper : lower, k == 0 ? threads / 2 : threads - threads / 2);
+        });
+        halves[0].first += halves[1].first;
+        halves[0].second += halves[1].second;
+        halves[0].score = score;
+        return std::move(halves[0]);
+    }
+};
+
+} // namespace AlignDetail
+
+// выровненная пара и score, как у traceBack(DP(seq1, seq2)), но в памяти O(|seq1| + |seq2|);
+// половины пути восстанавливаются параллельно в threads потоков
+inline std::pair<std::string, std::string> AlignLinear(std::string_view seq1, std::string_view seq2, int* score = nullptr,
+                                                       int threads = 1) {
+    const AlignDetail::LinearAligner aligner(seq1, seq2);
+    AlignDetail::Piece piece {0, 0, static_cast<int>(seq1.size()), static_cast<int>(seq2.size()), {}, {}};
+    piece.top.assign(seq2.size() + 1, gap);
+    piece.top[0] = 0;
+    piece.left.assign(seq1.size() + 1, gap);
+    piece.left[0] = 0;
+    AlignDetail::PieceResult result = aligner.Solve(piece, std::max(1, threads));
+    if (score) *score = result.score;
+    return {std::move(result.first), std::move(result.second)};
+}
+
+// score и восстановление выравнивания в линейной памяти: длинные белки не требуют квадратичной матрицы
+inline EdgeAlignment AlignSequences(std::string_view seq1, std::string_view seq2, int threads = 1) {
+    EdgeAlignment result;
+    std::tie(result.first, result.second) = AlignLinear(seq1, seq2, &result.score, threads);
+    int same = 0;
+    for (std::size_t k = 0; k < result.first.size(); ++k) {
+        if (result.first[k] != '-' && result.first[k] == result.second[k]) ++same;
+    }
+    if (!result.first.empty()) result.identity = static_cast<double>(same) / static_cast<double>(result.first.size());
+    return result;
+}
+
+// таблица выравниваний параллельно edges; ребра независимы и считаются в threads потоков
+inline std::vector<EdgeAlignment> AlignEdges(const ElementList& elements,
+                                             const std::vector<HasseBuilder::Edge>& edges, int threads = 1) {
+    std::vector<EdgeAlignment> result(edges.size());
+    ParallelFor(0, static_cast<int>(edges.size()), threads, [&](int i) {
+        result[i] = AlignSequences(elements[edges[i].first].string, elements[edges[i].second].string);
+    }, 16);
+    return result;
+}
+
+// только score ребер, без восстановления выравниваний: векторное ядро, ребра в threads потоков
+inline std::vector<int> ScoreEdges(const ElementList& elements, const std::vector<HasseBuilder::Edge>& edges,
+                                   int threads = 1) {
+    std::vector<int> result(edges.size());
+    const SimdLevel level = DefaultSimd(); // ошибка в AUTOLABA_SIMD - здесь, а не в рабочем потоке
+    ParallelFor(0, static_cast<int>(edges.size()), threads, [&](int i) {
+        result[i] = ScoreSequences(elements[edges[i].first].string, elements[edges[i].second].string, level);
+    }, 16);
+    return result;
+}
+
+inline std::vector<int> AlignmentScores(const std::vector<EdgeAlignment>& alignments) {
+    std::vector<int> result;
+    result.reserve(alignments.size());
+    for (const auto& a : alignments) result.push_back(a.score);
+    return result;
+}
+
+#endif //AUTOLABA_ALIGNMENT_H
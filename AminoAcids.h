@@ -1,87 +1,46 @@
 #ifndef AUTOLABA_AMINOACIDS_H
 #define AUTOLABA_AMINOACIDS_H
 
+#include <array>
+#include <cstdint>
 #include <iostream>
-#include <fstream>
-#include <sstream>
-#include <map>
+#include <stdexcept>
+#include <string_view>
 #include <vector>
 #include <iomanip>
 
-inline std::map<char, int> AminoToIndex; // словарь сопоставляющий каждой аминокислоте индекс для простой навигации по таблице BLOSUM62
-inline std::vector<std::vector<int>> scores; // таблица BLOSUM62
-inline std::string AllAminoAcids = "CSTAGPDEQNHRKMILVWYF"; // строка со всеми аминокислотами, представленными в таблице BLOSUM62
-inline int gap = -4;
+#include "SubstitutionMatrices.h"
 
-// деление заголовка таблицы для получения названия всех аминокислот
-inline std::vector<char> splitToAminoNo1(const std::string& header) {
-    std::vector<char> aminos;
-    std::stringstream ss(header);
-    std::string amino;
-    bool flag = false;
+// текущая таблица замен; по умолчанию BLOSUM62, собранная при компиляции
+inline SubstitutionTable Substitution = Blosum62Table;
+inline int gap = -4;
 
-    while (std::getline(ss, amino, ';')) {
-        if (flag) {
-            aminos.push_back(amino[0]);
-        } else {
-            flag = true;
-        }
-    }
-    return aminos;
+// выбор таблицы замен: имя встроенной (blosum62, blosum45, blosum80, pam250) или путь к CSV
+inline void UseSubstitutionMatrix(const std::string& nameOrPath) {
+    Substitution = LoadSubstitutionMatrix(nameOrPath);
 }
-// деление строки на ячейки для получения чисел для подсчета score
-inline std::vector<int> splitToScoreNo1(const std::string& line) {
-    std::vector<int> scores;
-    std::stringstream ss(line);
-    std::string score;
-    bool flag = false;
 
-    while (std::getline(ss, score, ';')) {
-        if (flag) {
-            scores.push_back(std::stoi(score));
-        } else {
-            flag = true;
-        }
-    }
-    return scores;
+// код аминокислоты в таблице замен; символов не из таблицы в последовательностях быть не должно
+inline std::uint8_t ResidueCode(char c) {
+    const std::uint8_t code = Substitution.code[static_cast<unsigned char>(c)];
+    if (code == UnknownResidue) throw std::runtime_error(std::string("Unknown amino acid: ") + c);
+    return code;
 }
 
-// прочтение таблицы BLOSUM62 и сохранение ее в удобном формате
-inline void readCSV() {
-    // открытие файла для чтения
-    std::ifstream file("/Users/meremikhina/Desktop/AutoLaba/BLOSUM62.csv");
-    if (!file.is_open()) {
-        std::cerr << "Не удалось открыть файл!\n";
-    }
-
-    // заполнение словаря AminoToIndex
-    std::string header;
-    std::getline(file, header);
-    std::vector<char> AminoAcids = splitToAminoNo1(header);
-
-    for (int i = 0; i < AminoAcids.size(); i++) {
-        AminoToIndex[AminoAcids[i]] = i;
-    }
-
-    // заполнение таблицы scores
-    std::string row;
-    while (std::getline(file, row, '\n')) {
-        scores.push_back(splitToScoreNo1(row));
-    }
-    file.close();
-}
-
-// нахождение значения для пары аминокислот по таблице BLOSUM62
+// нахождение значения для пары аминокислот по текущей таблице замен
 inline int score(const char A, const char B) {
-    int IndexA = AminoToIndex[A];
-    int IndexB = AminoToIndex[B];
-    return scores[IndexA][IndexB];
+    return Substitution.Score(ResidueCode(A), ResidueCode(B));
+}
+// перевод последовательности в коды таблицы замен: символ смотрится один раз, а не в каждой клетке DP
+inline void EncodeSequence(std::string_view seq, std::vector<std::uint8_t>& codes) {
+    codes.resize(seq.size());
+    for (std::size_t k = 0; k < seq.size(); ++k) codes[k] = ResidueCode(seq[k]);
 }
 // проверка на принадлежность последовательности к аминокислотной
-inline bool CheckSeq(const std::string& seq) {
+inline bool CheckSeq(std::string_view seq) {
     bool flag = true;
     for (char c : seq) {
-        if (AllAminoAcids.find(c) == std::string::npos) {
+        if (!Substitution.Has(c)) {
             flag = false;
             break;
         }
@@ -92,6 +51,9 @@ inline bool CheckSeq(const std::string& seq) {
 // написание динамического расчета для определения лучшего выравнивания для двух последовательностей
 inline std::vector<std::vector<int>> DP(const std::string& seq1, const std::string& seq2) {
     std::vector<std::vector<int>> dp(seq1.size() + 1, std::vector<int>(seq2.size() + 1, 0));
+    std::vector<std::uint8_t> a, b;
+    EncodeSequence(seq1, a);
+    EncodeSequence(seq2, b);
 
     // инициализация базы для динамического программирования
     dp[0][0] = 0;
@@ -104,16 +66,46 @@ inline std::vector<std::vector<int>> DP(const std::string& seq1, const std::stri
 
     // заполнение остальных ячеек дп матрицы
     for (int i = 1; i <= seq1.size(); i++) {
+        const std::int8_t* substitution = Substitution.Row(a[i - 1]);
         for (int j = 1; j <= seq2.size(); j++) {
-            dp[i][j] = std::max(dp[i - 1][j - 1] + score(seq1[i - 1], seq2[j - 1]), std::max(dp[i - 1][j] + gap, dp[i][j - 1] + gap));
+            dp[i][j] = std::max(dp[i - 1][j - 1] + substitution[b[j - 1]], std::max(dp[i - 1][j] + gap, dp[i][j - 1] + gap));
         }
     }
     return dp;
 }
-// определение числа выравнивания score
+// память для подсчета score, которая переиспользуется между вызовами (своя у каждого потока)
+struct AlignWorkspace {
+    std::vector<std::uint8_t> first;
+    std::vector<std::uint8_t> second;
+    std::vector<int> row;
+};
+
+// та же рекурсия, что в DP(), но хранится одна строка матрицы и значение по диагонали: O(m) памяти вместо O(n*m),
+// строка длины m + 1 помещается в кэш даже для самых длинных белков
+inline int ScoreEncoded(const std::uint8_t* a, std::size_t n, const std::uint8_t* b, std::size_t m, std::vector<int>& row) {
+    row.resize(m + 1);
+    row[0] = 0;
+    for (std::size_t j = 1; j <= m; ++j) row[j] = gap;
+    for (std::size_t i = 1; i <= n; ++i) {
+        const std::int8_t* substitution = Substitution.Row(a[i - 1]);
+        int diagonal = row[0]; // dp[i - 1][j - 1]
+        row[0] = gap;
+        for (std::size_t j = 1; j <= m; ++j) {
+            const int up = row[j];
+            row[j] = std::max(diagonal + substitution[b[j - 1]], std::max(up + gap, row[j - 1] + gap));
+            diagonal = up;
+        }
+    }
+    return row[m];
+}
+
+// определение числа выравнивания score без матрицы DP
 inline int Score(const std::string& seq1, const std::string& seq2) {
-    std::vector<std::vector<int>> dp = DP(seq1, seq2);
-    return dp[seq1.size()][seq2.size()];
+    thread_local AlignWorkspace workspace;
+    EncodeSequence(seq1, workspace.first);
+    EncodeSequence(seq2, workspace.second);
+    return ScoreEncoded(workspace.first.data(), workspace.first.size(), workspace.second.data(), workspace.second.size(),
+                        workspace.row);
 }
 // вывод таблицы выравнивания последовательностей
 inline void printDP(const std::vector<std::vector<int>>& dp, const std::string& seq1, const std::string& seq2) {
@@ -144,10 +136,13 @@ inline void printDP(const std::vector<std::vector<int>>& dp, const std::string&
 // восстановление выровненных последовательностей
 inline std::pair<std::string, std::string> traceBack(const std::vector<std::vector<int>>& dp, const std::string& seq1, const std::string& seq2) {
     std::pair<std::string, std::string> equal;
+    std::vector<std::uint8_t> a, b;
+    EncodeSequence(seq1, a);
+    EncodeSequence(seq2, b);
     size_t i = seq1.size();
     size_t j = seq2.size();
     while (i > 0 && j > 0) {
-        if (dp[i][j] == dp[i - 1][j - 1] + score(seq1[i - 1], seq2[j - 1])) {
+        if (dp[i][j] == dp[i - 1][j - 1] + Substitution.Score(a[i - 1], b[j - 1])) {
             equal.first.insert(0, 1, seq1[i - 1]);
             equal.second.insert(0, 1, seq2[j - 1]);
             i--;
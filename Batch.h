@@ -0,0 +1,329 @@
+#ifndef AUTOLABA_BATCH_H
+#define AUTOLABA_BATCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Input.h"
+#include "ElementFile.h"
+#include "HasseBuilder.h"
+#include "Graph.h"
+#include "GraphFile.h"
+#include "Layering.h"
+#include "PosetStats.h"
+#include "Export.h"
+#include "Raster.h"
+#include "Poster.h"
+#include "Svg.h"
+#include "Draw.h"
+#include "Alignment.h"
+
+/*
+ * Пакетный режим без вопросов в консоли:
+ *   AutoLaba --type int --rule divides --format dot,hsg --threads 8 --no-render a.txt b.hse
+ * Каждый файл проходит разбор -> дедупликацию -> построение -> экспорт; память переиспользуется.
+ */
+struct BatchOptions {
+    std::optional<InputMode> mode;
+    std::string rule;
+    bool bio = false;
+    std::string matrix;       // таблица замен для --bio: имя встроенной или путь к CSV, пусто - BLOSUM62
+    std::vector<ExportFormat> formats;
+    bool graphFile = false;   // формат hsg
+    bool png = false;         // формат png: программная отрисовка без окна
+    bool svg = false;         // формат svg: векторная картинка той же раскладки
+    bool poster = false;      // формат poster: большой PNG, отрисованный плитками
+    int imageSize = 600;
+    int posterSize = 16384;
+    bool pyramid = false;     // к постеру - пирамида Deep Zoom и страница просмотра
+    bool pngFast = false;     // быстрое сжатие png и постера: фильтр Up и короткие цепочки
+    int threads = 1;
+    bool render = true;
+    double maxFps = 0.0;      // ограничение частоты кадров окна, 0 - без ограничения
+    double layoutTime = 2.0;  // секунд на упорядочивание уровней, 0 - порядок индексов
+    bool printEdges = false;
+    std::string outDir = ".";
+    std::vector<std::string> inputs;
+};
+
+// память, которая переживает обработку одного файла
+struct BatchWorkspace {
+    std::vector<Element> elements;
+    std::vector<HasseBuilder::Edge> edges;
+    HasseBuilder::Workspace builder;
+};
+
+inline void PrintBatchUsage(std::ostream& out) {
+    out << "Usage: AutoLaba [options] FILE...\n"
+           "  --type int|string|set     element type of text inputs (.hse files carry their own)\n"
+           "  --rule NAME               divides|leq, prefix|lex|subseq, subset|size\n"
+           "  --bio                     amino-acid sequences, subsequence order (implies --type string)\n"
+           "  --matrix NAME|FILE        substitution matrix: blosum62 (default), blosum45, blosum80, pam250 or a CSV file\n"
+           "  --format LIST             comma-separated: dot,json,graphml,csv,hsg,png,svg,poster (default dot)\n"
+           "  --image-size N            side of the png/svg image in pixels (default 600)\n"
+           "  --poster-size N           side of the tiled poster image in pixels (default 16384)\n"
+           "  --pyramid                 also write a deep-zoom tile pyramid and an html viewer for the poster\n"
+           "  --png-fast                faster, larger png/poster encoding\n"
+           "  --threads N               worker threads for the build (default 1, 0 = all cores)\n"
+           "  --out DIR                 output directory (default .)\n"
+           "  --print-edges             print every edge to stdout\n"
+           "  --no-render               do not open a window\n"
+           "  --layout-time S           seconds spent reducing edge crossings (default 2, 0 = index order)\n"
+           "  --max-fps N               redraw the window at most N times per second (default: no cap)\n"
+           "  --bench-align             time the alignment kernels (scalar, sse4.1, avx2, avx512) and exit\n";
+}
+
+inline InputMode ParseInputMode(std::string_view name) {
+    if (name == "int") return InputMode::INT;
+    if (name == "string") return InputMode::STRING;
+    if (name == "set") return InputMode::SET_INT;
+    throw std::runtime_error("Unknown type: " + std::string(name));
+}
+
+inline Rules ParseRule(Element::Type type, std::string_view name) {
+    if (type == Element::Type::INT) {
+        if (name == "divides") return Rules::ForInt(Rules::IntRule::DIVIDES);
+        if (name == "leq") return Rules::ForInt(Rules::IntRule::LEQ);
+    } else if (type == Element::Type::STRING) {
+        if (name == "prefix") return Rules::ForString(Rules::StringRule::PREFIX);
+        if (name == "lex") return Rules::ForString(Rules::StringRule::LEX);
+        if (name == "subseq") return Rules::ForString(Rules::StringRule::SUBSEQ);
+    } else if (type == Element::Type::SET_INT) {
+        if (name == "subset") return Rules::ForSet(Rules::SetRule::SUBSET);
+        if (name == "size") return Rules::ForSet(Rules::SetRule::SIZE);
+    }
+    throw std::runtime_error("Rule '" + std::string(name) + "' does not fit the element type");
+}
+
+inline BatchOptions ParseBatchOptions(int argc, char** argv) {
+    BatchOptions options;
+    auto value = [&](int& i) -> std::string_view {
+        if (i + 1 >= argc) throw std::runtime_error(std::string("Missing value for ") + argv[i]);
+        return argv[++i];
+    };
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--type") {
+            options.mode = ParseInputMode(value(i));
+        } else if (arg == "--rule") {
+            options.rule = value(i);
+        } else if (arg == "--bio") {
+            options.bio = true;
+            options.mode = InputMode::STRING;
+            options.rule = "subseq";
+        } else if (arg == "--matrix") {
+            options.matrix = value(i);
+        } else if (arg == "--format") {
+            std::string_view list = value(i);
+            while (!list.empty()) {
+                const std::size_t comma = list.find(',');
+                const std::string_view name = list.substr(0, comma);
+                if (name == "hsg") options.graphFile = true;
+                else if (name == "png") options.png = true;
+                else if (name == "svg") options.svg = true;
+                else if (name == "poster") options.poster = true;
+                else options.formats.push_back(ParseExportFormat(name));
+                list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+            }
+        } else if (arg == "--threads") {
+            options.threads = std::stoi(std::string(value(i)));
+            if (options.threads <= 0) options.threads = HardwareThreads();
+        } else if (arg == "--image-size") {
+            options.imageSize = std::stoi(std::string(value(i)));
+            if (options.imageSize <= 0) throw std::runtime_error("--image-size must be positive");
+        } else if (arg == "--poster-size") {
+            options.posterSize = std::stoi(std::string(value(i)));
+            if (options.posterSize <= 0) throw std::runtime_error("--poster-size must be positive");
+        } else if (arg == "--pyramid") {
+            options.pyramid = true;
+        } else if (arg == "--png-fast") {
+            options.pngFast = true;
+        } else if (arg == "--out") {
+            options.outDir = value(i);
+        } else if (arg == "--print-edges") {
+            options.printEdges = true;
+        } else if (arg == "--max-fps") {
+            options.maxFps = std::stod(std::string(value(i)));
+            if (options.maxFps < 0.0) throw std::runtime_error("--max-fps must not be negative");
+        } else if (arg == "--layout-time") {
+            options.layoutTime = std::stod(std::string(value(i)));
+            if (options.layoutTime < 0.0) throw std::runtime_error("--layout-time must not be negative");
+        } else if (arg == "--no-render") {
+            options.render = false;
+        } else if (arg.starts_with("--")) {
+            throw std::runtime_error("Unknown option: " + std::string(arg));
+        } else {
+            options.inputs.emplace_back(arg);
+        }
+    }
+    if (options.inputs.empty()) throw std::runtime_error("No input files");
+    if (options.rule.empty()) throw std::runtime_error("--rule is required");
+    if (options.formats.empty() && !options.graphFile && !options.png && !options.svg &&
+        !options.poster) options.formats.push_back(ExportFormat::DOT);
+    return options;
+}
+
+// один файл: разбор -> дедупликация -> построение -> экспорт (-> окно)
+inline void RunBatchFile(const BatchOptions& options, const std::string& input, BatchWorkspace& ws) {
+    const auto start = std::chrono::steady_clock::now();
+    const std::filesystem::path inputPath(input);
+
+    // бинарный файл остается отображенным: построение, экспорт и подписи идут прямо по его данным
+    std::optional<ElementFile> binary;
+    Element::Type type = Element::Type::NONE;
+    if (inputPath.extension() == ".hse") {
+        binary.emplace(input);
+        type = binary->Type();
+        binary->DeduplicateStable();
+    } else {
+        if (!options.mode) throw std::runtime_error("--type is required for text input");
+        std::ifstream fin(input);
+        if (!fin) throw std::runtime_error("Cannot open file: " + input);
+        ReadElementsFromLines(fin, *options.mode, ws.elements);
+        type = ModeToElementType(*options.mode);
+        DeduplicateStable(ws.elements);
+    }
+    const ElementList elements = binary ? ElementList(*binary) : ElementList(ws.elements);
+    if (options.bio) {
+        if (type != Element::Type::STRING) throw std::runtime_error("--bio needs string elements");
+        for (std::size_t i = 0; i < elements.size(); ++i) {
+            const std::string_view seq = elements[i].string;
+            if (!CheckSeq(seq)) throw std::runtime_error("String data '" + std::string(seq) + "' is not a sequence of aminoacids");
+        }
+    }
+
+    const Rules rules = ParseRule(type, options.rule);
+    const int n = static_cast<int>(elements.size());
+    if (binary) {
+        HasseBuilder::BuildHasseEdges(n, binary->Comparator(rules), ws.edges, ws.builder, options.threads);
+    } else {
+        rules.Require(type);
+        HasseBuilder::BuildHasseEdges(n, [&](int i, int j) {
+            return rules.Compare(ws.elements[i], ws.elements[j]);
+        }, ws.edges, ws.builder, options.threads);
+    }
+
+    if (options.printEdges) {
+        for (const auto& [u, v] : ws.edges) {
+            std::cout << elements[u].ToString() << " -> " << elements[v].ToString() << "\n";
+        }
+    }
+
+    // замыкание нужно только секции reach в .hsg и числу сравнимых пар в DOT (и только для небольших графов);
+    // окно без него отвечает обходом CSR
+    const bool dot = std::find(options.formats.begin(), options.formats.end(), ExportFormat::DOT) != options.formats.end();
+    const HasseStructure hasse = HasseStructure::FromEdges(n, ws.edges, options.graphFile || dot);
+    const HasseGraph& graph = hasse.graph;
+    const Layering& layering = hasse.layering;
+    const PosetStats stats = ComputePosetStats(graph, layering, hasse.Reach());
+
+    const std::filesystem::path base = std::filesystem::path(options.outDir) / inputPath.stem();
+    for (ExportFormat format : options.formats) {
+        ExportGraph(format, base.string() + ExportExtension(format), elements, ws.edges, &stats);
+    }
+    if (options.graphFile) WriteGraphFile(base.string() + ".hsg", graph, layering.level, hasse.Reach());
+
+    // выравнивания ребер в режиме bio - один раз, для окна и для svg; svg без окна нужны только score
+    std::vector<EdgeAlignment> alignments;
+    if (options.bio && options.render) alignments = AlignEdges(elements, ws.edges, options.threads);
+
+    std::vector<DrawVertex> vertices;
+    if (options.png || options.svg || options.poster || options.render) {
+        LayoutOptions layout;
+        layout.threads = options.threads;
+        layout.timeBudget = options.layoutTime;
+        vertices = LayoutHasse(elements, graph, layering, layout);
+    }
+    PngOptions png = options.pngFast ? PngOptions::Fast() : PngOptions();
+    png.threads = options.threads;
+    if (options.png) RenderHassePng(base.string() + ".png", vertices, ws.edges, Radius, options.imageSize, options.imageSize, png);
+    if (options.poster) {
+        PosterOptions poster;
+        poster.width = poster.height = options.posterSize;
+        poster.threads = options.threads;
+        poster.pyramid = options.pyramid;
+        poster.png = png;
+        RenderPoster(base.string() + ".poster.png", vertices, ws.edges, Radius, poster);
+    }
+    if (options.svg) {
+        // в режиме bio у середины каждого ребра подписывается score выравнивания
+        std::vector<int> scores;
+        if (options.bio) scores = options.render ? AlignmentScores(alignments) : ScoreEdges(elements, ws.edges, options.threads);
+        SvgStyle style;
+        style.width = style.height = options.imageSize;
+        WriteSvg(base.string() + ".svg", vertices, ws.edges, Radius, scores, style);
+    }
+
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << input << ": " << n << " elements, " << ws.edges.size() << " edges, height " << stats.height
+              << ", width " << stats.width << ", " << ms << " ms\n";
+
+    if (options.render) {
+        ViewerOptions viewer;
+        viewer.maxFps = options.maxFps;
+        const int status = options.bio ? DrawHasseBio(vertices, ws.edges, graph, hasse.Reach(), alignments, viewer)
+                                       : DrawHasse(vertices, ws.edges, graph, hasse.Reach(), viewer);
+        if (status != 0) throw std::runtime_error("Cannot open a window for rendering");
+    }
+}
+
+// точка входа пакетного режима: 0 - все файлы обработаны, 1 - были ошибки, 2 - неверные аргументы
+inline int RunBatch(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::string_view(argv[i]) == "--help") {
+            PrintBatchUsage(std::cout);
+            return 0;
+        }
+        if (std::string_view(argv[i]) == "--bench-align") {
+            try {
+                return BenchmarkAlignment(std::cout) ? 0 : 1;
+            } catch (const std::exception& e) {
+                std::cerr << "Error: " << e.what() << "\n";
+                return 2;
+            }
+        }
+    }
+    BatchOptions options;
+    try {
+        options = ParseBatchOptions(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        PrintBatchUsage(std::cerr);
+        return 2;
+    }
+    if (!options.matrix.empty()) {
+        try {
+            UseSubstitutionMatrix(options.matrix);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 2;
+        }
+    }
+    try {
+        std::filesystem::create_directories(options.outDir);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 2;
+    }
+
+    BatchWorkspace ws;
+    int failed = 0;
+    for (const auto& input : options.inputs) {
+        try {
+            RunBatchFile(options, input, ws);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << input << ": " << e.what() << "\n";
+            ++failed;
+        }
+    }
+    return failed == 0 ? 0 : 1;
+}
+
+#endif //AUTOLABA_BATCH_H
@@ -0,0 +1,62 @@
+#ifndef AUTOLABA_CAMERA_H
+#define AUTOLABA_CAMERA_H
+
+#include <algorithm>
+
+#include "SpatialIndex.h"
+
+// масштаб и сдвиг нормализованных координат для шейдеров; тождественный по умолчанию
+struct ViewTransform {
+    float scaleX = 1.0f;
+    float scaleY = 1.0f;
+    float offsetX = 0.0f;
+    float offsetY = 0.0f;
+};
+
+// камера окна: точка раскладки в центре окна и увеличение; zoom = 1 - весь квадрат [-1, 1]
+struct Camera {
+    static constexpr float MinZoom = 0.25f;
+    static constexpr float MaxZoom = 100000.0f; // дальше не хватает точности float у координат вершин
+
+    float centerX = 0.0f;
+    float centerY = 0.0f;
+    float zoom = 1.0f;
+
+    ViewTransform View() const { return {zoom, zoom, -centerX * zoom, -centerY * zoom}; }
+
+    // что попадает в окно
+    WorldRect Visible() const {
+        const float half = 1.0f / zoom;
+        return {centerX - half, centerY - half, centerX + half, centerY + half};
+    }
+
+    // пиксель окна (начало - левый верхний угол, как у курсора GLFW) -> координаты раскладки
+    void ToWorld(double px, double py, int width, int height, float& x, float& y) const {
+        x = centerX + static_cast<float>(px / width * 2.0 - 1.0) / zoom;
+        y = centerY + static_cast<float>(1.0 - py / height * 2.0) / zoom;
+    }
+
+    // точка под курсором остается на месте
+    void ZoomAt(double px, double py, int width, int height, float factor) {
+        if (width <= 0 || height <= 0) return;
+        float beforeX, beforeY, afterX, afterY;
+        ToWorld(px, py, width, height, beforeX, beforeY);
+        zoom = std::clamp(zoom * factor, MinZoom, MaxZoom);
+        ToWorld(px, py, width, height, afterX, afterY);
+        centerX += beforeX - afterX;
+        centerY += beforeY - afterY;
+    }
+
+    // сдвиг на (dx, dy) пикселей окна: картинка едет вслед за курсором
+    void Pan(double dx, double dy, int width, int height) {
+        if (width <= 0 || height <= 0) return;
+        centerX -= static_cast<float>(dx / width * 2.0) / zoom;
+        centerY += static_cast<float>(dy / height * 2.0) / zoom;
+    }
+
+    void Reset() { *this = Camera(); }
+
+    bool operator==(const Camera&) const = default;
+};
+
+#endif //AUTOLABA_CAMERA_H
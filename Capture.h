@@ -0,0 +1,177 @@
+#ifndef AUTOLABA_CAPTURE_H
+#define AUTOLABA_CAPTURE_H
+
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "GlExt.h"
+#include "Parallel.h"
+#include "Png.h"
+
+// кадр, прочитанный из OpenGL (строки снизу вверх)
+struct CapturedFrame {
+    std::string path;
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> pixels;
+};
+
+// кодирование PNG в отдельном потоке, чтобы цикл отрисовки не ждал; сжатие - быстрым режимом на всех ядрах
+class ScreenshotWriter {
+private:
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<CapturedFrame> queue_;
+    bool stop_ = false;
+    std::thread worker_;
+
+    // строки кадра снизу вверх: писатель идет по ним с отрицательным шагом, без переворота копией
+    static void Save(const CapturedFrame& frame) {
+        const std::ptrdiff_t stride = static_cast<std::ptrdiff_t>(frame.width) * 3;
+        try {
+            WritePng(frame.path, frame.pixels.data() + stride * (frame.height - 1), frame.width, frame.height, 3, -stride,
+                     PngOptions::Fast(HardwareThreads()));
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << '\n';
+        }
+    }
+
+    void Run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            ready_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) return;
+            CapturedFrame frame = std::move(queue_.front());
+            queue_.pop_front();
+            lock.unlock();
+            Save(frame);
+            lock.lock();
+        }
+    }
+
+public:
+    ScreenshotWriter() : worker_([this] { Run(); }) {}
+    ScreenshotWriter(const ScreenshotWriter&) = delete;
+    ScreenshotWriter& operator=(const ScreenshotWriter&) = delete;
+    // очередь дописывается до конца: последний снимок не теряется при закрытии окна
+    ~ScreenshotWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        ready_.notify_one();
+        worker_.join();
+    }
+
+    void Push(CapturedFrame frame) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            // ждущий снимок в тот же файл устарел - пишется только последний
+            if (!queue_.empty() && queue_.back().path == frame.path) queue_.pop_back();
+            queue_.push_back(std::move(frame));
+        }
+        ready_.notify_one();
+    }
+};
+
+/*
+ * Снимок окна по запросу: Request() -> после отрисовки AfterRender() ставит glReadPixels в буфер пикселей
+ * (без ожидания GPU) -> Poll() в следующих кадрах забирает данные, когда барьер пройден, и отдает их писателю.
+ * Без буферов пикселей (старый контекст) чтение синхронное, но кодирование все равно в фоне.
+ */
+class FrameCapture {
+private:
+    GlExt gl_;
+    std::string path_;
+    ScreenshotWriter writer_;
+    GLuint buffer_ = 0;
+    std::size_t bufferSize_ = 0;
+    GlExt::SyncHandle fence_ = nullptr;
+    bool requested_ = false;
+    bool inFlight_ = false;
+    int framesWaited_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+
+    void Finish() {
+        gl_.BindBuffer(GL_PIXEL_PACK_BUFFER, buffer_);
+        CapturedFrame frame {path_, width_, height_, {}};
+        if (const void* data = gl_.MapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY)) {
+            const auto* bytes = static_cast<const unsigned char*>(data);
+            frame.pixels.assign(bytes, bytes + static_cast<std::size_t>(width_) * height_ * 3);
+            gl_.UnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        gl_.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        if (fence_) {
+            gl_.DeleteSync(fence_);
+            fence_ = nullptr;
+        }
+        inFlight_ = false;
+        if (!frame.pixels.empty()) writer_.Push(std::move(frame));
+    }
+
+public:
+    FrameCapture(const GlExt& gl, std::string path) : gl_(gl), path_(std::move(path)) {
+        if (gl_.HasPixelBuffers()) gl_.GenBuffers(1, &buffer_);
+    }
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+    ~FrameCapture() { Close(); }
+
+    // дочитать незавершенный снимок и освободить буфер; вызывать до уничтожения контекста
+    void Close() {
+        if (inFlight_) Finish();
+        if (buffer_) gl_.DeleteBuffers(1, &buffer_);
+        buffer_ = 0;
+    }
+
+    void Request() { requested_ = true; }
+    bool Pending() const { return requested_ || inFlight_; }
+
+    // после отрисовки кадра, до glfwSwapBuffers (читается задний буфер)
+    void AfterRender(int width, int height) {
+        if (!requested_ || inFlight_ || width <= 0 || height <= 0) return;
+        requested_ = false;
+        width_ = width;
+        height_ = height;
+        const std::size_t size = static_cast<std::size_t>(width) * height * 3;
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        if (!buffer_) {
+            CapturedFrame frame {path_, width, height, std::vector<unsigned char>(size)};
+            glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, frame.pixels.data());
+            writer_.Push(std::move(frame));
+            return;
+        }
+        gl_.BindBuffer(GL_PIXEL_PACK_BUFFER, buffer_);
+        if (size != bufferSize_) {
+            gl_.BufferData(GL_PIXEL_PACK_BUFFER, static_cast<std::ptrdiff_t>(size), nullptr, GL_STREAM_READ);
+            bufferSize_ = size;
+        }
+        glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+        gl_.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        fence_ = gl_.HasSync() ? gl_.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) : nullptr;
+        inFlight_ = true;
+        framesWaited_ = 0;
+    }
+
+    // раз в кадр: забрать готовое чтение; без барьеров данные считаются готовыми через два кадра
+    void Poll() {
+        if (!inFlight_) return;
+        ++framesWaited_;
+        if (fence_) {
+            const GLenum status = gl_.ClientWaitSync(fence_, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) return;
+        } else if (framesWaited_ < 2) {
+            return;
+        }
+        Finish();
+    }
+};
+
+#endif //AUTOLABA_CAPTURE_H
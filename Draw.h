@@ -2,121 +2,19 @@
 #define AUTOLABA_DRAW_H
 
 #include <algorithm>
-#include <map>
+#include <span>
+#include <string>
 #include <vector>
 #define GL_SILENCE_DEPRECATION
 #include <GLFW/glfw3.h>
-#include <GL/freeglut.h>
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "stb_image_write.h"
+#include "Viewer.h"
+#include "GpuGeometry.h"
+#include "TextAtlas.h"
 #include "HasseBuilder.h"
-#include "AminoAcids.h"
-
-inline float Radius = 0.0f;
-
-struct DrawVertex {
-    int index = 0;
-    std::string string;
-    float x = 0.0f;
-    float y = 0.0f;
-};
-
-// разделение вершин на уровни для удобства красивой визуализации
-inline std::map<int, std::vector<int>> levelIndex(const std::vector<HasseBuilder::Edge> &edges, const std::vector<Element>& elements) {
-    // std::map<int, std::vector<int>> result;
-    // std::vector<int> used;
-    // for (const auto & edge : edges) {
-    //     auto find1 = std::find(used.begin(), used.end(), edge.first);
-    //     if (find1 == used.end()) {
-    //         result[0].push_back(edge.first);
-    //         used.push_back(edge.first);
-    //     }
-    //     auto find2 = std::find(used.begin(), used.end(), edge.second);
-    //     if (find2 == used.end()) {
-    //         int x = edge.first;
-    //         auto it = std::find_if(result.begin(), result.end(),
-    //             [x](const auto& kv) {
-    //                 const std::vector<int>& v = kv.second;
-    //                 return std::find(v.begin(), v.end(), x) != v.end();
-    //         });
-    //         if (it != result.end()) {
-    //             result[it->first + 1].push_back(edge.second);
-    //             used.push_back(edge.second);
-    //         }
-    //     }
-    // }
-    // for (int i = 0; i < elements.size(); i++) {
-    //     auto find = std::find(used.begin(), used.end(), i);
-    //     if (find == used.end()) {
-    //         result[0].push_back(i);
-    //         used.push_back(i);
-    //     }
-    // }
-    // return result;
-    const int n = static_cast<int>(elements.size());
-
-    std::vector<std::vector<int>> adj(n);
-    std::vector<int> indeg(n, 0);
-    for (auto& e : edges) {
-        adj[e.first].push_back(e.second);
-        indeg[e.second]++;
-    }
-    std::queue<int> q;
-    std::vector<int> level(n, 0);
-
-    for (int i = 0; i < n; ++i)
-        if (indeg[i] == 0)
-            q.push(i);
-
-    while (!q.empty()) {
-        int u = q.front(); q.pop();
-        for (int v : adj[u]) {
-            level[v] = std::max(level[v], level[u] + 1);
-            if (--indeg[v] == 0)
-                q.push(v);
-        }
-    }
-    std::map<int, std::vector<int>> result;
-    for (int i = 0; i < n; ++i)
-        result[level[i]].push_back(i);
-    return result;
-}
-// просчет правильных шагов и радиуса, отталкиваясь от количества вершин
-inline std::pair<float, float> CountSteps(const std::map<int, std::vector<int>>& levels) {
-    const int levelCount = static_cast<int>(levels.size());
-    const float yStep = 2.0f / static_cast<float>(levelCount + 1);
-    int maxInLevel = 1;
-    for (auto& p : levels)
-        maxInLevel = std::max(maxInLevel, static_cast<int>(p.second.size()));
-
-    const float xStepMin = 2.0f / static_cast<float>(maxInLevel + 1);
-    const float outRadius = 0.35f * std::min(xStepMin, yStep);
-    std::pair<float, float> result;
-    result.first = yStep;
-    result.second = outRadius;
-    return result;
-}
-// определение структуры DrawVertex для каждой вершины диаграммы Хассе
-inline std::vector<DrawVertex> VerticesFromHasse(const std::vector<Element>& elements, const std::vector<HasseBuilder::Edge> &edges) {
-    std::vector<DrawVertex> vertices;
-    std::map<int, std::vector<int>> levels = levelIndex(edges, elements);
-    std::pair<float, float> counts = CountSteps(levels);
-    Radius = counts.second;
-
-    for (const auto& pair : levels) {
-        for (int i = 0; i < pair.second.size(); i++) {
-            DrawVertex vertex;
-            vertex.index = pair.second[i];
-            vertex.string = elements[pair.second[i]].ToString();
-            vertex.y = -1.0f + static_cast<float>(pair.first + 1) * counts.first;
-            // vertex.y = -1.0f + (0.2f + static_cast<float>(pair.first) * 0.2f) * 2.0f;
-            vertex.x = -1.0f + static_cast<float>(i + 1) * (2.0f / static_cast<float>(pair.second.size() + 1));
-            // vertex.x = ((static_cast<float>(i) + 1.0f) / (static_cast<float>(pair.second.size()) + 1.0f)) * 2.0f - 1.0f;
-            vertices.push_back(vertex);
-        }
-    }
-    return vertices;
-}
+#include "Layout.h"
+#include "SpatialIndex.h"
+#include "Inspect.h"
+#include "Alignment.h"
 
 // отрисовка кругов для вершин диаграммы
 inline void drawCircle(const float cx, const float cy, const float r, const int segments = 24) {
@@ -131,199 +29,333 @@ inline void drawCircle(const float cx, const float cy, const float r, const int
     }
     glEnd();
 }
-// отрисовка текста для подписи вершин
-inline void drawText(float x, float y, const char* text) {
-    glRasterPos2f(x, y);
-    for (const char* c = text; *c != '\0'; ++c) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, *c); // выбрать шрифт поменьше
+// построение таблицы выравниваний из готовых результатов (alignments идет параллельно edges)
+inline std::vector<std::string> GetTable(const std::vector<HasseBuilder::Edge> &edges, const std::vector<DrawVertex>& vertices,
+                                         const std::vector<EdgeAlignment>& alignments) {
+    std::vector<std::string> result(edges.size());
+    for (const EdgeSegment& e : EdgeGeometry(vertices, edges)) {
+        const EdgeAlignment& a = alignments[e.edge];
+        result[e.edge] = vertices[e.from].string + " -> " + vertices[e.to].string + " : " + a.first + "|" + a.second;
     }
+    return result;
 }
-inline int getTextWidth(const char* text, void* font) {
-    int width = 0;
-    for (const char* c = text; *c != '\0'; ++c)
-        width += glutBitmapWidth(font, *c);
-    return width;
-}
-inline void drawTextCentered(float x, float y, const char* text, void* font = GLUT_BITMAP_TIMES_ROMAN_24) {
-    int w = getTextWidth(text, font);
-    float scaleX = 1.0f / 600.0f;
-    float cx = x - (static_cast<float>(w) * scaleX) * 0.5f;
-    glRasterPos2f(cx, y);
-    for (const char* c = text; *c != '\0'; ++c)
-        glutBitmapCharacter(font, *c);
-}
+// вершины мельче этого радиуса (в пикселях) не рисуются: при сильном отдалении остаются одни ребра
+inline constexpr float MinCircleRadius = 0.5f;
+// выделенные вершины рисуются не мельче этого радиуса (в пикселях), чтобы выбор был виден издалека
+inline constexpr float MinHighlightRadius = 3.0f;
 
-// построение таблицы выравниваний
-inline std::vector<std::string> GetTable(const std::vector<HasseBuilder::Edge> &edges, const std::vector<DrawVertex>& vertices) {
-    std::vector<std::string> result;
-    for (const auto& e : edges) {
-        std::string elem;
-        auto it1 = std::find_if(vertices.begin(), vertices.end(),
-                [e](const DrawVertex& dv) { return dv.index == e.first; });
-        auto it2 = std::find_if(vertices.begin(), vertices.end(),
-            [e](const DrawVertex& dv) { return dv.index == e.second; });
-        if (it1 != vertices.end() && it2 != vertices.end()) {
-            elem = (*it1).string + " -> " + (*it2).string + " : ";
-            std::pair<std::string, std::string> Equally = traceBack(DP((*it1).string, (*it2).string), (*it1).string, (*it2).string);
-            elem += Equally.first + "|" + Equally.second;
-        }
-        result.push_back(elem);
+// список имен через запятую, не длиннее limit элементов
+inline std::string JoinNames(const std::vector<DrawVertex>& vertices, const std::vector<int>& slots,
+                             std::span<const int> elements, std::size_t limit = 6) {
+    std::string result;
+    for (std::size_t i = 0; i < elements.size() && i < limit; ++i) {
+        if (i) result += ", ";
+        const int slot = elements[i] < static_cast<int>(slots.size()) ? slots[elements[i]] : -1;
+        result += slot >= 0 ? vertices[slot].string : "#" + std::to_string(elements[i]);
     }
+    if (elements.size() > limit) result += ", ... (+" + std::to_string(elements.size() - limit) + ")";
     return result;
 }
-// отрисовка таблицы для выравниваний
-inline void drawAlignmentTable(const std::vector<std::string>& lines) {
-    float x = -0.95f;
-    float y = 0.95f;
-    float dy = 0.04f;
 
-    glColor3f(0.f, 0.f, 0.f);
+// сцена окна: ребра и круги из видеопамяти (или immediate mode, если контекст старый), подписи поверх;
+// при увеличении рисуется только то, что сетка нашла в окне; щелчок по вершине показывает ее окрестность
+class HasseScene {
+private:
+    const std::vector<DrawVertex>& vertices_;
+    std::vector<EdgeSegment> segments_;  // концы ребер находятся один раз, а не в каждом кадре
+    float radius_;
+    std::vector<int> scores_;            // score выравнивания каждого ребра (режим bio), иначе пусто
+    const std::vector<EdgeAlignment>* alignments_ = nullptr;
+    SpatialGrid grid_;
+    PosetInspector inspector_;
+    std::vector<int> slots_;             // индекс элемента -> позиция в vertices
+    std::vector<int> incidentOffsets_;   // позиция в vertices -> отрезки, которые ее касаются (CSR)
+    std::vector<int> incident_;
+    TextBatch vertexLabels_;             // подписи видимых вершин, собираются при смене камеры
+    TextBatch scoreLabels_;              // score у середины видимого ребра (режим bio)
+    TextBatch table_;                    // таблица выравниваний (режим bio)
+    GpuGeometry gpu_;
+    GlyphAtlas atlas_;
+    bool uploaded_ = false;              // загрузка в видеопамять уже пробовалась
 
-    for (const auto& s : lines) {
-        drawText(x, y, s.c_str());
-        y -= dy;
-    }
-}
+    // видимая часть для текущей камеры
+    bool visibleValid_ = false;
+    Camera visibleCamera_;
+    int visibleHeight_ = 0;
+    bool culled_ = false;                // false - в окне почти все, рисуется целиком без списков
+    std::vector<int> visibleVertices_;
+    std::vector<int> visibleSegments_;
+    std::vector<GLuint> lineIndices_;
+    std::vector<float> centers_;
 
-// сохранение графа на компьютер
-inline void saveScreenshot(GLFWwindow* window, const char* filename) {
-    int width, height;
-    glfwGetFramebufferSize(window, &width, &height);
-    std::vector<unsigned char> pixels(width * height * 3);
-    glPixelStorei(GL_PACK_ALIGNMENT, 1);
-    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+    // выбор и наведение (позиции в vertices, -1 - нет)
+    int hovered_ = -1;
+    int selected_ = -1;
+    std::vector<GLuint> selectionLines_; // покрытия выбранной вершины
+    std::vector<float> upCenters_;       // строго больше выбранной
+    std::vector<float> downCenters_;     // строго меньше
+    std::vector<float> selectedCenter_;
+    std::vector<float> hoveredCenter_;
+    TextBatch hoverLabel_;
+    TextBatch info_;                     // сведения о выбранной вершине в левом нижнем углу
 
-    // OpenGL хранит снизу вверх
-    std::vector<unsigned char> flipped(width * height * 3);
-    for (int y = 0; y < height; ++y) {
-        std::memcpy(
-            &flipped[y * width * 3],
-            &pixels[(height - 1 - y) * width * 3],
-            width * 3
-        );
+    void BuildIncidence() {
+        incidentOffsets_.assign(vertices_.size() + 1, 0);
+        for (const EdgeSegment& e : segments_) {
+            ++incidentOffsets_[e.from + 1];
+            ++incidentOffsets_[e.to + 1];
+        }
+        for (std::size_t v = 0; v < vertices_.size(); ++v) incidentOffsets_[v + 1] += incidentOffsets_[v];
+        incident_.resize(incidentOffsets_.back());
+        std::vector<int> cursor(incidentOffsets_.begin(), incidentOffsets_.end() - 1);
+        for (int s = 0; s < static_cast<int>(segments_.size()); ++s) {
+            incident_[cursor[segments_[s].from]++] = s;
+            incident_[cursor[segments_[s].to]++] = s;
+        }
     }
-    stbi_write_png(filename, width, height, 3, flipped.data(), width * 3);
-}
 
-// вырисовка диаграммы Хассе
-inline int DrawHasse(const std::vector<DrawVertex>& vertices, const std::vector<HasseBuilder::Edge> &edges) {
-    if (!glfwInit())
-        return -1;
-    GLFWwindow* window = glfwCreateWindow(600, 600, "HasseDiagram", nullptr, nullptr);
-    if (!window) {
-        glfwTerminate();
-        return -1;
+    void AddCenters(std::vector<float>& centers, std::span<const int> elements, int skip) const {
+        centers.clear();
+        for (int element : elements) {
+            const int slot = element < static_cast<int>(slots_.size()) ? slots_[element] : -1;
+            if (slot >= 0 && element != skip) centers.insert(centers.end(), {vertices_[slot].x, vertices_[slot].y});
+        }
+    }
+
+    // окрестность выбранной вершины: покрытия из CSR, верхнее и нижнее множества - только сейчас, по запросу
+    void BuildSelection() {
+        selectionLines_.clear();
+        upCenters_.clear();
+        downCenters_.clear();
+        selectedCenter_.clear();
+        info_.Clear();
+        if (selected_ < 0) return;
+        const DrawVertex& picked = vertices_[selected_];
+        selectedCenter_ = {picked.x, picked.y};
+        for (int k = incidentOffsets_[selected_]; k < incidentOffsets_[selected_ + 1]; ++k) {
+            selectionLines_.insert(selectionLines_.end(), {2u * incident_[k], 2u * incident_[k] + 1u});
+        }
+        const HasseGraph& graph = inspector_.Graph();
+        std::vector<std::string> lines {picked.string};
+        if (picked.index < graph.n) {
+            const std::vector<int> up = inspector_.UpSet(picked.index);
+            const std::vector<int> down = inspector_.DownSet(picked.index);
+            AddCenters(upCenters_, up, picked.index);
+            AddCenters(downCenters_, down, picked.index);
+            const std::span<const int> upper = graph.Out(picked.index);
+            const std::span<const int> lower = graph.In(picked.index);
+            lines.push_back("upper covers (" + std::to_string(upper.size()) + "): " + JoinNames(vertices_, slots_, upper));
+            lines.push_back("lower covers (" + std::to_string(lower.size()) + "): " + JoinNames(vertices_, slots_, lower));
+            lines.push_back("up-set: " + std::to_string(up.size()) + ", down-set: " + std::to_string(down.size()));
+        }
+        if (alignments_) {
+            const int shown = std::min(incidentOffsets_[selected_] + 8, incidentOffsets_[selected_ + 1]);
+            for (int k = incidentOffsets_[selected_]; k < shown; ++k) {
+                const EdgeSegment& e = segments_[incident_[k]];
+                const EdgeAlignment& a = (*alignments_)[e.edge];
+                lines.push_back(vertices_[e.from].string + " -> " + vertices_[e.to].string + ": " + a.first + "|" +
+                                a.second + " score " + std::to_string(a.score));
+            }
+        }
+        // строки снизу вверх от угла: последняя - на базовой линии
+        const int count = static_cast<int>(lines.size());
+        for (int i = 0; i < count; ++i) info_.Add(-0.95f, -0.95f, lines[i], TextBatch::Align::Left, i - (count - 1));
     }
-    glfwMakeContextCurrent(window);
-    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-    while (!glfwWindowShouldClose(window)) {
-        glClear(GL_COLOR_BUFFER_BIT);
 
-        glColor3f(0.f, 0.f, 0.f);
+    // отрезки по номерам концов (nullptr - все) и круги по центрам (nullptr - все): видеопамять или immediate mode
+    void DrawLines(const ViewTransform& view, const std::vector<GLuint>* indices, float r, float g, float b) const {
+        if (gpu_.Ready()) {
+            gpu_.DrawEdges(view, r, g, b, indices);
+            return;
+        }
+        glColor3f(r, g, b);
         glBegin(GL_LINES);
-        for (const auto& e : edges) {
-            auto it1 = std::find_if(vertices.begin(), vertices.end(),
-                [e](const DrawVertex& dv) { return dv.index == e.first; });
-            auto it2 = std::find_if(vertices.begin(), vertices.end(),
-                [e](const DrawVertex& dv) { return dv.index == e.second; });
-            if (it1 != vertices.end() && it2 != vertices.end()) {
-                const DrawVertex& parent = *it1;
-                const DrawVertex& child  = *it2;
-                glVertex2f(parent.x, parent.y);
-                glVertex2f(child.x,  child.y);
+        if (indices) {
+            for (GLuint i : *indices) {
+                const EdgeSegment& e = segments_[i / 2];
+                if (i % 2 == 0) glVertex2f(e.x0, e.y0);
+                else glVertex2f(e.x1, e.y1);
+            }
+        } else {
+            for (const EdgeSegment& e : segments_) {
+                glVertex2f(e.x0, e.y0);
+                glVertex2f(e.x1, e.y1);
             }
         }
         glEnd();
-
-        for (const auto & vertice : vertices) {
-            glColor3f(1.0f, 0.753f, 0.796f);
-            drawCircle(vertice.x, vertice.y, Radius);
-            // drawCircle(vertice.x, vertice.y, 0.1f);
-            glColor3f(0.f, 0.f, 0.f);
-            drawTextCentered(vertice.x, vertice.y - (Radius + 0.05f), vertice.string.c_str());
+    }
+    void DrawDiscs(const ViewTransform& view, const std::vector<float>* centers, float radius, float r, float g, float b) const {
+        if (gpu_.Ready()) {
+            gpu_.DrawCircles(view, radius, r, g, b, centers);
+            return;
+        }
+        glColor3f(r, g, b);
+        if (centers) {
+            for (std::size_t i = 0; i + 1 < centers->size(); i += 2) drawCircle((*centers)[i], (*centers)[i + 1], radius);
+        } else {
+            for (const DrawVertex& v : vertices_) drawCircle(v.x, v.y, radius);
         }
-        glfwSwapBuffers(window);
-        glfwPollEvents();
-        saveScreenshot(window, "screenshot.png");
     }
-    glfwDestroyWindow(window);
-    glfwTerminate();
-    return 0;
-}
 
-// вырисовка диаграммы Хассе для биоинформатики
-inline int DrawHasseBio(const std::vector<DrawVertex>& vertices, const std::vector<HasseBuilder::Edge> &edges) {
-    if (!glfwInit())
-        return -1;
-    GLFWwindow* window = glfwCreateWindow(600, 600, "HasseDiagramBio", nullptr, nullptr);
-    if (!window) {
-        glfwTerminate();
-        return -1;
+    void UpdateVisible(const Camera& camera, int height, bool labels) {
+        visibleValid_ = true;
+        visibleCamera_ = camera;
+        visibleHeight_ = height;
+        // запас на радиус круга и подпись под ним
+        const float pixel = 2.0f / (static_cast<float>(std::max(1, height)) * camera.zoom);
+        const float margin = radius_ + 40.0f * pixel;
+        WorldRect rect = camera.Visible();
+        rect.x0 -= margin;
+        rect.y0 -= margin;
+        rect.x1 += margin;
+        rect.y1 += margin;
+        culled_ = 2 * grid_.CellsIn(rect) < grid_.CellCount();
+        if (culled_) {
+            grid_.Query(rect, visibleVertices_, visibleSegments_);
+            lineIndices_.clear();
+            for (int s : visibleSegments_) lineIndices_.insert(lineIndices_.end(), {2u * s, 2u * s + 1u});
+            centers_.clear();
+            for (int v : visibleVertices_) centers_.insert(centers_.end(), {vertices_[v].x, vertices_[v].y});
+        }
+
+        vertexLabels_.Clear();
+        scoreLabels_.Clear();
+        if (!labels) return;
+        auto addVertex = [&](const DrawVertex& v) {
+            vertexLabels_.Add(v.x, v.y - radius_, v.string, TextBatch::Align::Center, 1);
+        };
+        auto addScore = [&](const EdgeSegment& e) {
+            const float dx = e.x1 - e.x0;
+            const float dy = e.y1 - e.y0;
+            const float len = std::sqrt(dx * dx + dy * dy);
+            if (len <= 0.0f) return;
+            const float offset = 15.0f * pixel; // смещение от ребра по нормали
+            scoreLabels_.Add((e.x0 + e.x1) * 0.5f - dy / len * offset, (e.y0 + e.y1) * 0.5f + dx / len * offset,
+                             std::to_string(scores_[e.edge]), TextBatch::Align::Center);
+        };
+        if (culled_) {
+            for (int v : visibleVertices_) addVertex(vertices_[v]);
+            if (!scores_.empty()) for (int s : visibleSegments_) addScore(segments_[s]);
+        } else {
+            for (const DrawVertex& v : vertices_) addVertex(v);
+            if (!scores_.empty()) for (const EdgeSegment& e : segments_) addScore(e);
+        }
     }
-    glfwMakeContextCurrent(window);
-    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-    while (!glfwWindowShouldClose(window)) {
-        glClear(GL_COLOR_BUFFER_BIT);
 
-        // отрисовка ребер
-        glColor3f(0.f, 0.f, 0.f);
-        glBegin(GL_LINES);
-        for (const auto& e : edges) {
-            auto it1 = std::find_if(vertices.begin(), vertices.end(),
-                [e](const DrawVertex& dv) { return dv.index == e.first; });
-            auto it2 = std::find_if(vertices.begin(), vertices.end(),
-                [e](const DrawVertex& dv) { return dv.index == e.second; });
-            if (it1 != vertices.end() && it2 != vertices.end()) {
-                const DrawVertex& parent = *it1;
-                const DrawVertex& child  = *it2;
-                glVertex2f(parent.x, parent.y);
-                glVertex2f(child.x,  child.y);
-            }
+public:
+    // graph - тот же граф, что и edges; reach может быть nullptr
+    HasseScene(const std::vector<DrawVertex>& vertices, const std::vector<HasseBuilder::Edge>& edges, float radius,
+               const HasseGraph& graph, const Reachability* reach)
+        : vertices_(vertices), segments_(EdgeGeometry(vertices, edges)), radius_(radius), inspector_(graph, reach),
+          slots_(VertexSlots(vertices)) {
+        grid_.Build(vertices_, segments_);
+        BuildIncidence();
+    }
+    // таблица собирается один раз из посчитанных выравниваний (alignments идет параллельно edges и должен жить дольше сцены)
+    HasseScene(const std::vector<DrawVertex>& vertices, const std::vector<HasseBuilder::Edge>& edges, float radius,
+               const HasseGraph& graph, const Reachability* reach, const std::vector<EdgeAlignment>& alignments)
+        : HasseScene(vertices, edges, radius, graph, reach) {
+        alignments_ = &alignments;
+        scores_ = AlignmentScores(alignments);
+        const std::vector<std::string> table = GetTable(edges, vertices, alignments);
+        for (int i = 0; i < static_cast<int>(table.size()); ++i) {
+            table_.Add(-0.95f, 0.95f, table[i], TextBatch::Align::Left, i);
         }
-        glEnd();
+    }
 
-        // отрисовка score для последовательностей
-        for (const auto& e : edges) {
-            auto it1 = std::find_if(vertices.begin(), vertices.end(),
-                [e](const DrawVertex& dv) { return dv.index == e.first; });
-            auto it2 = std::find_if(vertices.begin(), vertices.end(),
-                [e](const DrawVertex& dv) { return dv.index == e.second; });
+    // курсор над (x, y) в координатах раскладки; true - изменилось то, что нарисовано
+    bool Hover(float x, float y, float pickRadius) {
+        const int slot = grid_.Nearest(vertices_, x, y, std::max(pickRadius, radius_));
+        if (slot == hovered_) return false;
+        hovered_ = slot;
+        hoveredCenter_.clear();
+        hoverLabel_.Clear();
+        if (slot >= 0) {
+            hoveredCenter_ = {vertices_[slot].x, vertices_[slot].y};
+            hoverLabel_.Add(vertices_[slot].x, vertices_[slot].y - radius_, vertices_[slot].string, TextBatch::Align::Center, 1);
+        }
+        return true;
+    }
+    // щелчок: выбор вершины под курсором, щелчок мимо снимает выбор
+    bool Select(float x, float y, float pickRadius) {
+        const int slot = grid_.Nearest(vertices_, x, y, std::max(pickRadius, radius_));
+        if (slot == selected_) return false;
+        selected_ = slot;
+        BuildSelection();
+        return true;
+    }
 
-            if (it1 != vertices.end() && it2 != vertices.end()) {
-                const DrawVertex& parent = *it1;
-                const DrawVertex& child  = *it2;
-                // отрисовка score
-                float dx = child.x - parent.x;
-                float dy = child.y - parent.y;
-                float len = std::sqrt(dx*dx + dy*dy);
-                float nx = -dy / len;
-                float ny =  dx / len;
-                float mx = (parent.x + child.x) * 0.5f;
-                float my = (parent.y + child.y) * 0.5f;
+    void Draw(const GlExt& gl, int width, int height, const Camera& camera) {
+        if (!uploaded_) {
+            gpu_.Upload(gl, vertices_, segments_);
+            atlas_.Create(gl);
+            uploaded_ = true;
+        }
+        const ViewTransform view = camera.View();
+        // размер шрифта растет вместе с окном; детали пропадают по мере отдаления: сначала подписи, потом круги
+        const int textScale = std::max(1, height / 300);
+        const float radiusPixels = radius_ * camera.zoom * 0.5f * static_cast<float>(height);
+        const bool labels = radiusPixels >= MinLabelRadius;
+        const bool circles = radiusPixels >= MinCircleRadius;
+        if (!visibleValid_ || !(visibleCamera_ == camera) || visibleHeight_ != height) UpdateVisible(camera, height, labels);
 
-                float offset = 0.05f; // регулируем размер смещения
-                std::string label = std::to_string(Score(parent.string, child.string));
-                drawTextCentered(mx + nx * offset, my + ny * offset, label.c_str());
-                // отрисовка выравнивания
-                std::vector<std::string> table = GetTable(edges, vertices);
-                drawAlignmentTable(table);
-            }
+        // immediate mode получает камеру через матрицу
+        if (!gpu_.Ready()) {
+            glMatrixMode(GL_MODELVIEW);
+            glLoadIdentity();
+            glTranslatef(view.offsetX, view.offsetY, 0.0f);
+            glScalef(view.scaleX, view.scaleY, 1.0f);
         }
 
-        // отрисовка вершин с названиями
-        for (const auto & vertice : vertices) {
-            glColor3f(1.0f, 0.753f, 0.796f);
-            drawCircle(vertice.x, vertice.y, Radius);
-            glColor3f(0.f, 0.f, 0.f);
-            drawTextCentered(vertice.x, vertice.y - (Radius + 0.05f), vertice.string.c_str());
+        // отрисовка ребер, покрытия выбранной вершины - поверх
+        DrawLines(view, culled_ ? &lineIndices_ : nullptr, 0.f, 0.f, 0.f);
+        if (!selectionLines_.empty()) DrawLines(view, &selectionLines_, 0.85f, 0.1f, 0.1f);
+
+        // отрисовка вершин; выбранная и ее верхнее/нижнее множества видны при любом увеличении
+        if (circles) DrawDiscs(view, culled_ ? &centers_ : nullptr, radius_, 1.0f, 0.753f, 0.796f);
+        const float highlight = std::max(radius_, MinHighlightRadius * 2.0f / (static_cast<float>(height) * camera.zoom));
+        if (!downCenters_.empty()) DrawDiscs(view, &downCenters_, highlight, 0.55f, 0.85f, 0.55f);
+        if (!upCenters_.empty()) DrawDiscs(view, &upCenters_, highlight, 0.5f, 0.7f, 1.0f);
+        if (!selectedCenter_.empty()) DrawDiscs(view, &selectedCenter_, highlight, 0.9f, 0.2f, 0.2f);
+        if (!hoveredCenter_.empty()) DrawDiscs(view, &hoveredCenter_, highlight, 1.0f, 0.6f, 0.2f);
+        if (!gpu_.Ready()) glLoadIdentity();
+
+        // подписи: score у ребер, названия вершин, вершина под курсором, таблица выравнивания и сведения о выбранной
+        if (labels) {
+            atlas_.Draw(scoreLabels_, view, width, height, textScale, 0.f, 0.f, 0.f);
+            atlas_.Draw(vertexLabels_, view, width, height, textScale, 0.f, 0.f, 0.f);
+        } else {
+            atlas_.Draw(hoverLabel_, view, width, height, textScale, 0.f, 0.f, 0.f);
         }
-        glfwSwapBuffers(window);
-        glfwPollEvents();
-        saveScreenshot(window, "screenshot.png");
+        atlas_.Draw(table_, ViewTransform {}, width, height, textScale, 0.f, 0.f, 0.f);
+        atlas_.Draw(info_, ViewTransform {}, width, height, textScale, 0.f, 0.f, 0.5f);
+    }
+
+    void Release() {
+        gpu_.Release();
+        atlas_.Release();
+        vertexLabels_.Release();
+        scoreLabels_.Release();
+        table_.Release();
+        hoverLabel_.Release();
+        info_.Release();
+        uploaded_ = false;
     }
-    glfwDestroyWindow(window);
-    glfwTerminate();
-    return 0;
+};
+
+// вырисовка диаграммы Хассе; graph и reach (может быть nullptr) нужны для сведений о выбранной вершине
+inline int DrawHasse(const std::vector<DrawVertex>& vertices, const std::vector<HasseBuilder::Edge> &edges,
+                     const HasseGraph& graph, const Reachability* reach, const ViewerOptions& options = {}) {
+    HasseScene scene(vertices, edges, Radius, graph, reach);
+    return RunViewer("HasseDiagram", scene, options);
+}
+
+// вырисовка диаграммы Хассе для биоинформатики
+inline int DrawHasseBio(const std::vector<DrawVertex>& vertices, const std::vector<HasseBuilder::Edge> &edges,
+                        const HasseGraph& graph, const Reachability* reach, const std::vector<EdgeAlignment>& alignments,
+                        const ViewerOptions& options = {}) {
+    HasseScene scene(vertices, edges, Radius, graph, reach, alignments);
+    return RunViewer("HasseDiagramBio", scene, options);
 }
 
-#endif //AUTOLABA_DRAW_H
\ No newline at end of file
+#endif //AUTOLABA_DRAW_H
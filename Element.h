@@ -1,5 +1,8 @@
+#include <cstdint>
+#include <span>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <algorithm>
 #include <utility>
@@ -94,6 +97,30 @@ private:
         return "NONE";
     }
 
+    // хеш FNV-1a по типу и содержимому; одинаков для Element и "сырых" значений из бинарного файла
+    static std::uint64_t HashBytes(Type t, const void* data, std::size_t size) {
+        std::uint64_t h = 14695981039346656037ull ^ static_cast<std::uint64_t>(t);
+        const auto* p = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; ++i) {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+    static std::uint64_t HashOf(int v) { return HashBytes(Type::INT, &v, sizeof(v)); }
+    static std::uint64_t HashOf(std::string_view s) { return HashBytes(Type::STRING, s.data(), s.size()); }
+    static std::uint64_t HashOf(std::span<const int> set) { return HashBytes(Type::SET_INT, set.data(), set.size_bytes()); }
+
+    std::uint64_t Hash() const {
+        switch (type) {
+            case Type::STRING: return HashOf(std::string_view(str));
+            case Type::INT:    return HashOf(val);
+            case Type::SET_INT: return HashOf(std::span<const int>(set_int));
+            case Type::NONE: return HashBytes(Type::NONE, nullptr, 0);
+        }
+        return 0;
+    }
+
     bool operator==(const Element& other) const {
         if (type != other.type) return false;
             switch (type) {
@@ -105,4 +132,81 @@ private:
             return false;
     }
 };
+
+// элемент без владения: значение берется из Element или прямо из отображенного бинарного файла, без копий
+struct ElementView {
+    Element::Type type = Element::Type::NONE;
+    int value = 0;
+    std::string_view string;
+    std::span<const int> set;
+
+    ElementView() = default;
+    ElementView(const Element& e) : type(e.GetType()) {
+        switch (type) {
+            case Element::Type::STRING:  string = e.AsString(); break;
+            case Element::Type::INT:     value = e.AsInt(); break;
+            case Element::Type::SET_INT: set = e.AsSetInt(); break;
+            case Element::Type::NONE:    break;
+        }
+    }
+    static ElementView OfInt(int v) {
+        ElementView e;
+        e.type = Element::Type::INT;
+        e.value = v;
+        return e;
+    }
+    static ElementView OfString(std::string_view s) {
+        ElementView e;
+        e.type = Element::Type::STRING;
+        e.string = s;
+        return e;
+    }
+    static ElementView OfSet(std::span<const int> s) {
+        ElementView e;
+        e.type = Element::Type::SET_INT;
+        e.set = s;
+        return e;
+    }
+
+    std::uint64_t Hash() const {
+        switch (type) {
+            case Element::Type::STRING:  return Element::HashOf(string);
+            case Element::Type::INT:     return Element::HashOf(value);
+            case Element::Type::SET_INT: return Element::HashOf(set);
+            case Element::Type::NONE:    break;
+        }
+        return Element::HashBytes(Element::Type::NONE, nullptr, 0);
+    }
+
+    // подпись в том же виде, что Element::ToString()
+    std::string ToString() const {
+        switch (type) {
+            case Element::Type::STRING:  return std::string(string);
+            case Element::Type::INT:     return std::to_string(value);
+            case Element::Type::SET_INT: {
+                std::string s;
+                s.push_back('[');
+                for (std::size_t i = 0; i < set.size(); i++) {
+                    s += std::to_string(set[i]);
+                    if (i + 1 != set.size()) s += ", ";
+                }
+                s.push_back(']');
+                return s;
+            }
+            case Element::Type::NONE:    break;
+        }
+        return "NONE";
+    }
+
+    bool operator==(const ElementView& other) const {
+        if (type != other.type) return false;
+        switch (type) {
+            case Element::Type::STRING:  return string == other.string;
+            case Element::Type::INT:     return value == other.value;
+            case Element::Type::SET_INT: return std::equal(set.begin(), set.end(), other.set.begin(), other.set.end());
+            case Element::Type::NONE:    return true;
+        }
+        return false;
+    }
+};
 #endif //AUTOLABA_ELEMENT_H
\ No newline at end of file
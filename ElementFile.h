@@ -0,0 +1,281 @@
+#ifndef AUTOLABA_ELEMENTFILE_H
+#define AUTOLABA_ELEMENTFILE_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Input.h"
+#include "MappedFile.h"
+
+/*
+ * Бинарный колоночный формат элементов (.hse), little-endian:
+ *   заголовок ElementFileHeader;
+ *   секция data:  INT     - int32[count]
+ *                 STRING  - uint64 offsets[count + 1] в секцию bytes
+ *                 SET_INT - uint64 offsets[count + 1] (CSR) в секцию bytes, где лежат int32
+ *   секция bytes: символы строк или числа множеств (только для STRING и SET_INT);
+ *   секция hash:  uint64[count] - Element::Hash() каждого элемента (если есть флаг HASHES), по ней идет дедупликация.
+ * Все секции выровнены по 8 байт, поэтому после mmap к ним можно обращаться напрямую.
+ */
+struct ElementFileHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t type;
+    std::uint32_t flags;
+    std::uint64_t count;
+    std::uint64_t dataOffset;
+    std::uint64_t dataSize;
+    std::uint64_t bytesOffset;
+    std::uint64_t bytesSize;
+    std::uint64_t hashOffset;
+};
+
+inline constexpr char ElementFileMagic[4] = {'H', 'S', 'E', 'L'};
+inline constexpr std::uint32_t ElementFileVersion = 1;
+inline constexpr std::uint32_t ElementFileDeduplicated = 1u << 0; // повторов нет, дедупликацию можно пропустить
+inline constexpr std::uint32_t ElementFileHashes = 1u << 1;       // есть колонка хешей
+
+static_assert(sizeof(int) == sizeof(std::int32_t), "ElementFile stores int as int32");
+
+// запись элементов в бинарный формат; при dedup повторы удаляются с сохранением порядка
+inline void WriteElementFile(const std::vector<Element>& input, const std::string& path, bool dedup = true, bool hashes = true) {
+    if (input.empty()) throw std::runtime_error("No elements were provided");
+    const Element::Type type = input.front().GetType();
+
+    std::vector<const Element*> elements;
+    std::vector<std::uint64_t> hashColumn;
+    elements.reserve(input.size());
+    hashColumn.reserve(input.size());
+    std::unordered_multimap<std::uint64_t, const Element*> seen;
+    for (const auto& e : input) {
+        if (e.GetType() != type) throw std::runtime_error("ElementFile: mixed element types");
+        const std::uint64_t h = e.Hash();
+        if (dedup) {
+            bool duplicate = false;
+            auto [first, last] = seen.equal_range(h);
+            for (auto it = first; it != last; ++it) {
+                if (*it->second == e) {
+                    duplicate = true;
+                    break;
+                }
+            }
+            if (duplicate) continue;
+            seen.emplace(h, &e);
+        }
+        elements.push_back(&e);
+        hashColumn.push_back(h);
+    }
+
+    std::vector<unsigned char> data;
+    std::vector<unsigned char> bytes;
+    auto append = [](std::vector<unsigned char>& out, const void* p, std::size_t size) {
+        const auto* b = static_cast<const unsigned char*>(p);
+        out.insert(out.end(), b, b + size);
+    };
+    if (type == Element::Type::INT) {
+        for (const Element* e : elements) {
+            const std::int32_t v = e->AsInt();
+            append(data, &v, sizeof(v));
+        }
+    } else {
+        std::uint64_t offset = 0;
+        append(data, &offset, sizeof(offset));
+        for (const Element* e : elements) {
+            if (type == Element::Type::STRING) {
+                const std::string& s = e->AsString();
+                append(bytes, s.data(), s.size());
+            } else {
+                const std::vector<int>& set = e->AsSetInt();
+                append(bytes, set.data(), set.size() * sizeof(int));
+            }
+            offset = bytes.size();
+            append(data, &offset, sizeof(offset));
+        }
+    }
+
+    auto align8 = [](std::uint64_t x) { return (x + 7) & ~std::uint64_t{7}; };
+    ElementFileHeader header {};
+    std::memcpy(header.magic, ElementFileMagic, sizeof(header.magic));
+    header.version = ElementFileVersion;
+    header.type = static_cast<std::uint32_t>(type);
+    header.flags = (dedup ? ElementFileDeduplicated : 0u) | (hashes ? ElementFileHashes : 0u);
+    header.count = elements.size();
+    header.dataOffset = align8(sizeof(ElementFileHeader));
+    header.dataSize = data.size();
+    header.bytesOffset = align8(header.dataOffset + header.dataSize);
+    header.bytesSize = bytes.size();
+    header.hashOffset = hashes ? align8(header.bytesOffset + header.bytesSize) : 0;
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out) throw std::runtime_error("Cannot write file: " + path);
+    auto writeAt = [&out](std::uint64_t offset, const void* p, std::size_t size) {
+        const auto pos = static_cast<std::uint64_t>(out.tellp());
+        static constexpr char zeros[8] = {};
+        out.write(zeros, static_cast<std::streamsize>(offset - pos));
+        out.write(static_cast<const char*>(p), static_cast<std::streamsize>(size));
+    };
+    writeAt(0, &header, sizeof(header));
+    writeAt(header.dataOffset, data.data(), data.size());
+    writeAt(header.bytesOffset, bytes.data(), bytes.size());
+    if (hashes) writeAt(header.hashOffset, hashColumn.data(), hashColumn.size() * sizeof(std::uint64_t));
+    if (!out) throw std::runtime_error("Cannot write file: " + path);
+}
+
+// конвертер из текущего текстового формата (один элемент в строке)
+inline void ConvertTextToElementFile(std::istream& in, InputMode mode, const std::string& path, bool dedup = true) {
+    WriteElementFile(ReadElementsFromLines(in, mode), path, dedup);
+}
+
+// загрузка бинарного файла через mmap: элементы отдаются как span/string_view без разбора и аллокаций
+class ElementFile {
+private:
+    MappedFile file_;
+    ElementFileHeader header_ {};
+    const std::int32_t* ints_ = nullptr;
+    const std::uint64_t* offsets_ = nullptr;
+    const char* bytes_ = nullptr;
+    const std::uint64_t* hashes_ = nullptr;
+    std::vector<std::uint32_t> rows_; // строки файла, оставшиеся после DeduplicateStable; пусто - все подряд
+
+    std::size_t Row(std::size_t i) const { return rows_.empty() ? i : rows_[i]; }
+
+    void Fail(const std::string& what) const {
+        throw std::runtime_error("Bad element file: " + what);
+    }
+
+public:
+    explicit ElementFile(const std::string& path) : file_(path) {
+        const std::uint64_t size = file_.Size();
+        if (size < sizeof(ElementFileHeader)) Fail("too small");
+        std::memcpy(&header_, file_.Data(), sizeof(header_));
+        if (std::memcmp(header_.magic, ElementFileMagic, sizeof(header_.magic)) != 0) Fail("wrong magic");
+        if (header_.version != ElementFileVersion) Fail("unsupported version");
+
+        const Element::Type type = Type();
+        if (type != Element::Type::INT && type != Element::Type::STRING && type != Element::Type::SET_INT) Fail("unknown type");
+        auto inside = [size](std::uint64_t offset, std::uint64_t length) {
+            return offset % 8 == 0 && offset <= size && length <= size - offset;
+        };
+        // count не доверяется: сначала сравнивается с размером файла, только потом умножается на ширину записи
+        const std::uint64_t n = header_.count;
+        const std::uint64_t width = type == Element::Type::INT ? sizeof(std::int32_t) : sizeof(std::uint64_t);
+        if (n >= size / width || n > static_cast<std::uint64_t>(std::numeric_limits<int>::max())) Fail("count");
+        const std::uint64_t expected = type == Element::Type::INT ? n * width : (n + 1) * width;
+        if (header_.dataSize != expected || !inside(header_.dataOffset, header_.dataSize)) Fail("data section");
+        if (!inside(header_.bytesOffset, header_.bytesSize)) Fail("bytes section");
+        if (HasHashes() && (n > size / sizeof(std::uint64_t) || !inside(header_.hashOffset, n * sizeof(std::uint64_t)))) {
+            Fail("hash section");
+        }
+
+        const unsigned char* base = file_.Data();
+        if (type == Element::Type::INT) {
+            ints_ = reinterpret_cast<const std::int32_t*>(base + header_.dataOffset);
+        } else {
+            offsets_ = reinterpret_cast<const std::uint64_t*>(base + header_.dataOffset);
+            bytes_ = reinterpret_cast<const char*>(base + header_.bytesOffset);
+            // один последовательный проход, чтобы дальнейшие обращения не выходили за секцию bytes
+            const std::uint64_t unit = type == Element::Type::SET_INT ? sizeof(std::int32_t) : 1;
+            if (offsets_[0] != 0 || offsets_[n] != header_.bytesSize) Fail("offsets");
+            for (std::uint64_t i = 0; i < n; ++i) {
+                if (offsets_[i] > offsets_[i + 1] || offsets_[i] % unit != 0) Fail("offsets");
+            }
+        }
+        if (HasHashes()) hashes_ = reinterpret_cast<const std::uint64_t*>(base + header_.hashOffset);
+    }
+
+    Element::Type Type() const { return static_cast<Element::Type>(header_.type); }
+    // число элементов после DeduplicateStable (индексы ниже - в этой нумерации, а не строки файла)
+    std::size_t Count() const { return rows_.empty() ? static_cast<std::size_t>(header_.count) : rows_.size(); }
+    bool IsDeduplicated() const { return (header_.flags & ElementFileDeduplicated) != 0; }
+    bool HasHashes() const { return (header_.flags & ElementFileHashes) != 0; }
+
+    int IntAt(std::size_t i) const { return ints_[Row(i)]; }
+    std::string_view StringAt(std::size_t i) const {
+        const std::size_t r = Row(i);
+        return {bytes_ + offsets_[r], static_cast<std::size_t>(offsets_[r + 1] - offsets_[r])};
+    }
+    std::span<const int> SetAt(std::size_t i) const {
+        const std::size_t r = Row(i);
+        return {reinterpret_cast<const int*>(bytes_ + offsets_[r]), static_cast<std::size_t>(offsets_[r + 1] - offsets_[r]) / sizeof(int)};
+    }
+    ElementView At(std::size_t i) const {
+        switch (Type()) {
+            case Element::Type::INT:     return ElementView::OfInt(IntAt(i));
+            case Element::Type::STRING:  return ElementView::OfString(StringAt(i));
+            case Element::Type::SET_INT: return ElementView::OfSet(SetAt(i));
+            case Element::Type::NONE:    break;
+        }
+        return {};
+    }
+    // хеш из колонки файла, если она есть, иначе по данным
+    std::uint64_t HashAt(std::size_t i) const { return hashes_ ? hashes_[Row(i)] : At(i).Hash(); }
+
+    // удаление повторов с сохранением порядка первых вхождений, как DeduplicateStable для вектора;
+    // данные не копируются - запоминаются только строки файла, которые остались. Возвращает число удаленных
+    int DeduplicateStable() {
+        if (IsDeduplicated()) return 0;
+        const std::size_t n = Count();
+        std::unordered_multimap<std::uint64_t, std::uint32_t> seen;
+        seen.reserve(n);
+        std::vector<std::uint32_t> kept;
+        kept.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            const std::uint64_t h = HashAt(i);
+            const ElementView e = At(i);
+            bool duplicate = false;
+            auto [first, last] = seen.equal_range(h);
+            for (auto it = first; it != last; ++it) {
+                if (At(it->second) == e) {
+                    duplicate = true;
+                    break;
+                }
+            }
+            if (duplicate) continue;
+            seen.emplace(h, static_cast<std::uint32_t>(i));
+            kept.push_back(static_cast<std::uint32_t>(Row(i)));
+        }
+        const int removed = static_cast<int>(n - kept.size());
+        if (removed > 0) rows_ = std::move(kept);
+        return removed;
+    }
+
+    // сравнение для HasseBuilder::BuildHasseEdges(n, compare) прямо по отображенным данным
+    auto Comparator(const Rules& rules) const {
+        rules.Require(Type());
+        return [this, &rules](int i, int j) {
+            switch (Type()) {
+                case Element::Type::INT:     return rules.CompareInts(IntAt(i), IntAt(j));
+                case Element::Type::STRING:  return rules.CompareStrings(StringAt(i), StringAt(j));
+                case Element::Type::SET_INT: return rules.CompareSets(SetAt(i), SetAt(j));
+                case Element::Type::NONE:    break;
+            }
+            return Rules::Cmp::Incomparable;
+        };
+    }
+};
+
+// элементы вершин для построения и вывода: вектор Element (консоль, текст) или бинарный файл;
+// к элементам обращаются через ElementView, поэтому файл не превращается в Element ни целиком, ни по одному
+class ElementList {
+private:
+    const std::vector<Element>* elements_ = nullptr;
+    const ElementFile* file_ = nullptr;
+
+public:
+    ElementList(const std::vector<Element>& elements) : elements_(&elements) {}
+    ElementList(const ElementFile& file) : file_(&file) {}
+
+    std::size_t size() const { return file_ ? file_->Count() : elements_->size(); }
+    bool empty() const { return size() == 0; }
+    ElementView operator[](std::size_t i) const { return file_ ? file_->At(i) : ElementView((*elements_)[i]); }
+};
+
+#endif //AUTOLABA_ELEMENTFILE_H
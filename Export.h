@@ -0,0 +1,335 @@
+#ifndef AUTOLABA_EXPORT_H
+#define AUTOLABA_EXPORT_H
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "ElementFile.h"
+#include "HasseBuilder.h"
+#include "PosetStats.h"
+
+// буферизованная запись прямо в файловый дескриптор: память постоянна при любом размере вывода
+class BufferedWriter {
+private:
+    int fd_ = -1;
+    std::string path_;
+    std::vector<char> buffer_;
+    std::size_t used_ = 0;
+
+    // причина из errno (например, нет места на диске) попадает в текст ошибки
+    [[noreturn]] void Fail() const {
+        throw std::runtime_error("Write failed: " + path_ + " (" + std::strerror(errno) + ")");
+    }
+
+public:
+    explicit BufferedWriter(const std::string& path, std::size_t capacity = 1 << 20)
+        : path_(path), buffer_(capacity) {
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) throw std::runtime_error("Cannot write file: " + path + " (" + std::strerror(errno) + ")");
+    }
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+    ~BufferedWriter() {
+        if (fd_ < 0) return;
+        try {
+            Flush();
+        } catch (...) {
+        }
+        ::close(fd_);
+    }
+
+    void Flush() {
+        std::size_t done = 0;
+        while (done < used_) {
+            const ssize_t w = ::write(fd_, buffer_.data() + done, used_ - done);
+            if (w < 0) Fail();
+            done += static_cast<std::size_t>(w);
+        }
+        used_ = 0;
+    }
+    // явное закрытие, чтобы ошибки записи не терялись в деструкторе
+    void Close() {
+        Flush();
+        const int fd = fd_;
+        fd_ = -1;
+        if (::close(fd) != 0) Fail();
+    }
+
+    void Write(std::string_view s) {
+        if (s.size() > buffer_.size() - used_) {
+            Flush();
+            if (s.size() > buffer_.size()) {
+                std::size_t done = 0;
+                while (done < s.size()) {
+                    const ssize_t w = ::write(fd_, s.data() + done, s.size() - done);
+                    if (w < 0) Fail();
+                    done += static_cast<std::size_t>(w);
+                }
+                return;
+            }
+        }
+        std::memcpy(buffer_.data() + used_, s.data(), s.size());
+        used_ += s.size();
+    }
+    void Put(char c) {
+        if (used_ == buffer_.size()) Flush();
+        buffer_[used_++] = c;
+    }
+    void WriteInt(long long v) {
+        char tmp[24];
+        const auto res = std::to_chars(tmp, tmp + sizeof(tmp), v);
+        Write(std::string_view(tmp, static_cast<std::size_t>(res.ptr - tmp)));
+    }
+    void WriteFixed(double v, int precision) {
+        char tmp[64];
+        const auto res = std::to_chars(tmp, tmp + sizeof(tmp), v, std::chars_format::fixed, precision);
+        Write(std::string_view(tmp, static_cast<std::size_t>(res.ptr - tmp)));
+    }
+
+    // экранирование кусками: обычные участки копируются целиком, escape(c) вызывается только на спецсимволах
+    template <class Escape>
+    void WriteEscaped(std::string_view s, std::string_view special, Escape&& escape) {
+        std::size_t start = 0;
+        while (start < s.size()) {
+            const std::size_t pos = s.find_first_of(special, start);
+            if (pos == std::string_view::npos) {
+                Write(s.substr(start));
+                return;
+            }
+            Write(s.substr(start, pos - start));
+            escape(*this, s[pos]);
+            start = pos + 1;
+        }
+    }
+};
+
+enum class ExportFormat { DOT, JSON, GRAPHML, CSV };
+
+inline ExportFormat ParseExportFormat(std::string_view name) {
+    if (name == "dot") return ExportFormat::DOT;
+    if (name == "json") return ExportFormat::JSON;
+    if (name == "graphml") return ExportFormat::GRAPHML;
+    if (name == "csv") return ExportFormat::CSV;
+    throw std::runtime_error("Unknown export format: " + std::string(name));
+}
+inline const char* ExportExtension(ExportFormat format) {
+    switch (format) {
+        case ExportFormat::DOT:     return ".dot";
+        case ExportFormat::JSON:    return ".json";
+        case ExportFormat::GRAPHML: return ".graphml";
+        case ExportFormat::CSV:     return ".csv";
+    }
+    return "";
+}
+
+// правила экранирования подписей для каждого формата
+inline void WriteDotLabel(BufferedWriter& out, std::string_view s) {
+    out.WriteEscaped(s, "\\\"\n", [](BufferedWriter& w, char c) {
+        if (c == '\n') { w.Write("\\n"); return; }
+        w.Put('\\');
+        w.Put(c);
+    });
+}
+inline void WriteJsonString(BufferedWriter& out, std::string_view s) {
+    // кавычка, обратная косая черта и все управляющие символы 0x00-0x1F (длина задана явно из-за '\0')
+    static constexpr std::string_view special("\"\\\0\x01\x02\x03\x04\x05\x06\x07\x08\t\n\x0b\x0c\r\x0e\x0f"
+                                              "\x10\x11\x12\x13\x14\x15\x16\x17\x18\x19\x1a\x1b\x1c\x1d\x1e\x1f", 34);
+    out.WriteEscaped(s, special, [](BufferedWriter& w, char c) {
+        switch (c) {
+            case '"':  w.Write("\\\""); return;
+            case '\\': w.Write("\\\\"); return;
+            case '\n': w.Write("\\n"); return;
+            case '\t': w.Write("\\t"); return;
+            case '\r': w.Write("\\r"); return;
+            default: {
+                static constexpr char hex[] = "0123456789abcdef";
+                const char u[] = {'\\', 'u', '0', '0', hex[(c >> 4) & 0xF], hex[c & 0xF]};
+                w.Write(std::string_view(u, sizeof(u)));
+            }
+        }
+    });
+}
+inline void WriteXmlText(BufferedWriter& out, std::string_view s) {
+    out.WriteEscaped(s, "&<>\"'", [](BufferedWriter& w, char c) {
+        switch (c) {
+            case '&': w.Write("&amp;"); return;
+            case '<': w.Write("&lt;"); return;
+            case '>': w.Write("&gt;"); return;
+            case '"': w.Write("&quot;"); return;
+            default:  w.Write("&apos;"); return;
+        }
+    });
+}
+inline void WriteCsvField(BufferedWriter& out, std::string_view s) {
+    if (s.find_first_of(",\"\n\r") == std::string_view::npos) {
+        out.Write(s);
+        return;
+    }
+    out.Put('"');
+    out.WriteEscaped(s, "\"", [](BufferedWriter& w, char) { w.Write("\"\""); });
+    out.Put('"');
+}
+
+// подпись элемента без промежуточной строки ToString(): числа идут через to_chars
+template <class Text>
+void WriteElementLabel(BufferedWriter& out, const ElementView& e, Text&& text) {
+    switch (e.type) {
+        case Element::Type::STRING:
+            text(out, e.string);
+            return;
+        case Element::Type::INT:
+            out.WriteInt(e.value);
+            return;
+        case Element::Type::SET_INT: {
+            out.Put('[');
+            for (std::size_t i = 0; i < e.set.size(); ++i) {
+                if (i) out.Write(", ");
+                out.WriteInt(e.set[i]);
+            }
+            out.Put(']');
+            return;
+        }
+        case Element::Type::NONE:
+            text(out, "NONE");
+            return;
+    }
+}
+
+// вывод экстремальных характеристик после графа
+inline void WriteExtremeCharacteristics(BufferedWriter& out, const ElementList& elements, const PosetStats& stats) {
+    auto writeList = [&](const std::vector<int>& list) {
+        out.Put('[');
+        for (std::size_t i = 0; i < list.size(); ++i) {
+            if (i) out.Write(", ");
+            WriteElementLabel(out, elements[list[i]], [](BufferedWriter& w, std::string_view s) { w.Write(s); });
+        }
+        out.Put(']');
+    };
+    out.Write("\nExtreme characteristics:\nMinimal elements: ");
+    writeList(stats.minimal);
+    out.Write("\nMaximal elements: ");
+    writeList(stats.maximal);
+    out.Write("\nHeight: ");
+    out.WriteInt(stats.height);
+    out.Write("\nWidth: ");
+    out.WriteInt(stats.width);
+    if (stats.comparablePairs >= 0) {
+        out.Write("\nComparable pairs: ");
+        out.WriteInt(stats.comparablePairs);
+    }
+}
+
+inline void WriteDot(BufferedWriter& out, const ElementList& elements, const std::vector<HasseBuilder::Edge>& edges,
+                     const PosetStats* stats = nullptr) {
+    out.Write("digraph Hasse {\n  rankdir=BT;\n  node [shape=circle];\n");
+    for (int i = 0; i < static_cast<int>(elements.size()); ++i) {
+        out.Write("  n");
+        out.WriteInt(i);
+        out.Write(" [label=\"");
+        WriteElementLabel(out, elements[i], WriteDotLabel);
+        out.Write("\"];\n");
+    }
+    for (const auto& [u, v] : edges) {
+        out.Write("  n");
+        out.WriteInt(u);
+        out.Write(" -> n");
+        out.WriteInt(v);
+        out.Write(";\n");
+    }
+    out.Write("}\n");
+    if (stats) WriteExtremeCharacteristics(out, elements, *stats);
+}
+
+inline void WriteJson(BufferedWriter& out, const ElementList& elements, const std::vector<HasseBuilder::Edge>& edges) {
+    out.Write("{\"nodes\":[");
+    for (int i = 0; i < static_cast<int>(elements.size()); ++i) {
+        if (i) out.Put(',');
+        out.Write("\n{\"id\":");
+        out.WriteInt(i);
+        out.Write(",\"label\":\"");
+        WriteElementLabel(out, elements[i], WriteJsonString);
+        out.Write("\"}");
+    }
+    out.Write("\n],\"edges\":[");
+    bool first = true;
+    for (const auto& [u, v] : edges) {
+        if (!first) out.Put(',');
+        first = false;
+        out.Write("\n[");
+        out.WriteInt(u);
+        out.Put(',');
+        out.WriteInt(v);
+        out.Put(']');
+    }
+    out.Write("\n]}\n");
+}
+
+inline void WriteGraphML(BufferedWriter& out, const ElementList& elements, const std::vector<HasseBuilder::Edge>& edges) {
+    out.Write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+              "<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\">\n"
+              "  <key id=\"label\" for=\"node\" attr.name=\"label\" attr.type=\"string\"/>\n"
+              "  <graph id=\"Hasse\" edgedefault=\"directed\">\n");
+    for (int i = 0; i < static_cast<int>(elements.size()); ++i) {
+        out.Write("    <node id=\"n");
+        out.WriteInt(i);
+        out.Write("\"><data key=\"label\">");
+        WriteElementLabel(out, elements[i], WriteXmlText);
+        out.Write("</data></node>\n");
+    }
+    for (const auto& [u, v] : edges) {
+        out.Write("    <edge source=\"n");
+        out.WriteInt(u);
+        out.Write("\" target=\"n");
+        out.WriteInt(v);
+        out.Write("\"/>\n");
+    }
+    out.Write("  </graph>\n</graphml>\n");
+}
+
+// список ребер: индексы и подписи концов
+inline void WriteEdgeCsv(BufferedWriter& out, const ElementList& elements, const std::vector<HasseBuilder::Edge>& edges) {
+    out.Write("source,target,source_label,target_label\n");
+    auto label = [&](int i) {
+        if (elements[i].type != Element::Type::SET_INT) {
+            WriteElementLabel(out, elements[i], WriteCsvField);
+            return;
+        }
+        // подпись множества "[1, 2]" содержит запятые и всегда берется в кавычки
+        out.Put('"');
+        WriteElementLabel(out, elements[i], WriteCsvField);
+        out.Put('"');
+    };
+    for (const auto& [u, v] : edges) {
+        out.WriteInt(u);
+        out.Put(',');
+        out.WriteInt(v);
+        out.Put(',');
+        label(u);
+        out.Put(',');
+        label(v);
+        out.Put('\n');
+    }
+}
+
+// stats дописываются только в DOT (как раньше делал ToDot)
+inline void ExportGraph(ExportFormat format, const std::string& path, const ElementList& elements, const std::vector<HasseBuilder::Edge>& edges,
+                        const PosetStats* stats = nullptr) {
+    BufferedWriter out(path);
+    switch (format) {
+        case ExportFormat::DOT:     WriteDot(out, elements, edges, stats); break;
+        case ExportFormat::JSON:    WriteJson(out, elements, edges); break;
+        case ExportFormat::GRAPHML: WriteGraphML(out, elements, edges); break;
+        case ExportFormat::CSV:     WriteEdgeCsv(out, elements, edges); break;
+    }
+    out.Close();
+}
+
+#endif //AUTOLABA_EXPORT_H
@@ -0,0 +1,180 @@
+#ifndef AUTOLABA_GLEXT_H
+#define AUTOLABA_GLEXT_H
+
+#include <cstddef>
+#include <initializer_list>
+#define GL_SILENCE_DEPRECATION
+#include <GLFW/glfw3.h>
+
+// функции OpenGL новее 1.1 берутся через glfwGetProcAddress: системный gl.h их не экспортирует везде
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88E1
+#endif
+#ifndef GL_READ_ONLY
+#define GL_READ_ONLY 0x88B8
+#endif
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#endif
+#ifndef GL_STATIC_DRAW
+#define GL_STATIC_DRAW 0x88E4
+#endif
+#ifndef GL_VERTEX_SHADER
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_LINK_STATUS 0x8B82
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_ALREADY_SIGNALED 0x911A
+#define GL_CONDITION_SATISFIED 0x911C
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#endif
+
+struct GlExt {
+    using SyncHandle = struct __GLsync*;
+
+    void (APIENTRY* GenBuffers)(GLsizei, GLuint*) = nullptr;
+    void (APIENTRY* DeleteBuffers)(GLsizei, const GLuint*) = nullptr;
+    void (APIENTRY* BindBuffer)(GLenum, GLuint) = nullptr;
+    void (APIENTRY* BufferData)(GLenum, std::ptrdiff_t, const void*, GLenum) = nullptr;
+    void* (APIENTRY* MapBuffer)(GLenum, GLenum) = nullptr;
+    GLboolean (APIENTRY* UnmapBuffer)(GLenum) = nullptr;
+    SyncHandle (APIENTRY* FenceSync)(GLenum, GLbitfield) = nullptr;
+    GLenum (APIENTRY* ClientWaitSync)(SyncHandle, GLbitfield, unsigned long long) = nullptr;
+    void (APIENTRY* DeleteSync)(SyncHandle) = nullptr;
+
+    GLuint (APIENTRY* CreateShader)(GLenum) = nullptr;
+    void (APIENTRY* ShaderSource)(GLuint, GLsizei, const char* const*, const GLint*) = nullptr;
+    void (APIENTRY* CompileShader)(GLuint) = nullptr;
+    void (APIENTRY* GetShaderiv)(GLuint, GLenum, GLint*) = nullptr;
+    void (APIENTRY* DeleteShader)(GLuint) = nullptr;
+    GLuint (APIENTRY* CreateProgram)() = nullptr;
+    void (APIENTRY* AttachShader)(GLuint, GLuint) = nullptr;
+    void (APIENTRY* BindAttribLocation)(GLuint, GLuint, const char*) = nullptr;
+    void (APIENTRY* LinkProgram)(GLuint) = nullptr;
+    void (APIENTRY* GetProgramiv)(GLuint, GLenum, GLint*) = nullptr;
+    void (APIENTRY* DeleteProgram)(GLuint) = nullptr;
+    void (APIENTRY* UseProgram)(GLuint) = nullptr;
+    GLint (APIENTRY* GetUniformLocation)(GLuint, const char*) = nullptr;
+    void (APIENTRY* Uniform1f)(GLint, GLfloat) = nullptr;
+    void (APIENTRY* Uniform1i)(GLint, GLint) = nullptr;
+    void (APIENTRY* Uniform2f)(GLint, GLfloat, GLfloat) = nullptr;
+    void (APIENTRY* Uniform4f)(GLint, GLfloat, GLfloat, GLfloat, GLfloat) = nullptr;
+    void (APIENTRY* EnableVertexAttribArray)(GLuint) = nullptr;
+    void (APIENTRY* DisableVertexAttribArray)(GLuint) = nullptr;
+    void (APIENTRY* VertexAttribPointer)(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*) = nullptr;
+    void (APIENTRY* VertexAttribDivisor)(GLuint, GLuint) = nullptr;
+    void (APIENTRY* DrawArraysInstanced)(GLenum, GLint, GLsizei, GLsizei) = nullptr;
+
+    // буферы пикселей (OpenGL 2.1) - асинхронное чтение кадра
+    bool HasPixelBuffers() const {
+        return GenBuffers && DeleteBuffers && BindBuffer && BufferData && MapBuffer && UnmapBuffer;
+    }
+    // барьеры (OpenGL 3.2 / ARB_sync) - проверка готовности без ожидания
+    bool HasSync() const { return FenceSync && ClientWaitSync && DeleteSync; }
+
+    // шейдеры и буферы вершин (OpenGL 2.0)
+    bool HasShaders() const {
+        return BindBuffer && BufferData && GenBuffers && DeleteBuffers && CreateShader && ShaderSource &&
+               CompileShader && GetShaderiv && DeleteShader && CreateProgram && AttachShader && BindAttribLocation &&
+               LinkProgram && GetProgramiv && DeleteProgram && UseProgram && GetUniformLocation && Uniform1f &&
+               Uniform1i && Uniform2f && Uniform4f && EnableVertexAttribArray && DisableVertexAttribArray &&
+               VertexAttribPointer;
+    }
+    // шейдеры (OpenGL 2.0) и экземпляры (3.3 или ARB_instanced_arrays + ARB_draw_instanced)
+    bool HasInstancedShaders() const { return HasShaders() && VertexAttribDivisor && DrawArraysInstanced; }
+
+    // вызывать после glfwMakeContextCurrent: адреса функций зависят от контекста
+    static GlExt Load() {
+        GlExt gl;
+        Resolve(gl.GenBuffers, "glGenBuffers");
+        Resolve(gl.DeleteBuffers, "glDeleteBuffers");
+        Resolve(gl.BindBuffer, "glBindBuffer");
+        Resolve(gl.BufferData, "glBufferData");
+        Resolve(gl.MapBuffer, "glMapBuffer");
+        Resolve(gl.UnmapBuffer, "glUnmapBuffer");
+        Resolve(gl.FenceSync, "glFenceSync");
+        Resolve(gl.ClientWaitSync, "glClientWaitSync");
+        Resolve(gl.DeleteSync, "glDeleteSync");
+        Resolve(gl.CreateShader, "glCreateShader");
+        Resolve(gl.ShaderSource, "glShaderSource");
+        Resolve(gl.CompileShader, "glCompileShader");
+        Resolve(gl.GetShaderiv, "glGetShaderiv");
+        Resolve(gl.DeleteShader, "glDeleteShader");
+        Resolve(gl.CreateProgram, "glCreateProgram");
+        Resolve(gl.AttachShader, "glAttachShader");
+        Resolve(gl.BindAttribLocation, "glBindAttribLocation");
+        Resolve(gl.LinkProgram, "glLinkProgram");
+        Resolve(gl.GetProgramiv, "glGetProgramiv");
+        Resolve(gl.DeleteProgram, "glDeleteProgram");
+        Resolve(gl.UseProgram, "glUseProgram");
+        Resolve(gl.GetUniformLocation, "glGetUniformLocation");
+        Resolve(gl.Uniform1f, "glUniform1f");
+        Resolve(gl.Uniform1i, "glUniform1i");
+        Resolve(gl.Uniform2f, "glUniform2f");
+        Resolve(gl.Uniform4f, "glUniform4f");
+        Resolve(gl.EnableVertexAttribArray, "glEnableVertexAttribArray");
+        Resolve(gl.DisableVertexAttribArray, "glDisableVertexAttribArray");
+        Resolve(gl.VertexAttribPointer, "glVertexAttribPointer");
+        Resolve(gl.VertexAttribDivisor, "glVertexAttribDivisor");
+        if (!gl.VertexAttribDivisor) Resolve(gl.VertexAttribDivisor, "glVertexAttribDivisorARB");
+        Resolve(gl.DrawArraysInstanced, "glDrawArraysInstanced");
+        if (!gl.DrawArraysInstanced) Resolve(gl.DrawArraysInstanced, "glDrawArraysInstancedARB");
+        return gl;
+    }
+
+private:
+    template <class F>
+    static void Resolve(F& f, const char* name) {
+        f = reinterpret_cast<F>(glfwGetProcAddress(name));
+    }
+};
+
+// сборка программы из двух шейдеров; attributes - имена входов по порядку номеров; 0 - ошибка компиляции
+inline GLuint BuildProgram(const GlExt& gl, const char* vertexSource, const char* fragmentSource,
+                           std::initializer_list<const char*> attributes) {
+    auto compile = [&gl](GLenum type, const char* source) -> GLuint {
+        const GLuint shader = gl.CreateShader(type);
+        gl.ShaderSource(shader, 1, &source, nullptr);
+        gl.CompileShader(shader);
+        GLint ok = 0;
+        gl.GetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+        if (!ok) {
+            gl.DeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    };
+    const GLuint vs = compile(GL_VERTEX_SHADER, vertexSource);
+    const GLuint fs = compile(GL_FRAGMENT_SHADER, fragmentSource);
+    GLuint program = 0;
+    if (vs && fs) {
+        program = gl.CreateProgram();
+        gl.AttachShader(program, vs);
+        gl.AttachShader(program, fs);
+        GLuint location = 0;
+        for (const char* name : attributes) gl.BindAttribLocation(program, location++, name);
+        gl.LinkProgram(program);
+        GLint ok = 0;
+        gl.GetProgramiv(program, GL_LINK_STATUS, &ok);
+        if (!ok) {
+            gl.DeleteProgram(program);
+            program = 0;
+        }
+    }
+    if (vs) gl.DeleteShader(vs);
+    if (fs) gl.DeleteShader(fs);
+    return program;
+}
+
+#endif //AUTOLABA_GLEXT_H
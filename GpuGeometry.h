@@ -0,0 +1,171 @@
+#ifndef AUTOLABA_GPUGEOMETRY_H
+#define AUTOLABA_GPUGEOMETRY_H
+
+#include <vector>
+
+#include "Camera.h"
+#include "GlExt.h"
+#include "Layout.h"
+
+// геометрия диаграммы в видеопамяти: загружается один раз на раскладку, кадр - два вызова отрисовки
+
+class GpuGeometry {
+private:
+    GlExt gl_;
+    GLuint edgeProgram_ = 0;
+    GLuint circleProgram_ = 0;
+    GLuint edgeBuffer_ = 0;    // концы отрезков (x, y) для GL_LINES
+    GLuint cornerBuffer_ = 0;  // 4 угла квадрата [-1, 1]^2 - общий для всех кругов
+    GLuint centerBuffer_ = 0;  // центр каждого круга, по одному на экземпляр
+    GLsizei edgeVertices_ = 0;
+    GLsizei circles_ = 0;
+
+    static constexpr const char* EdgeVertexShader = R"(#version 120
+attribute vec2 position;
+uniform vec4 view;
+void main() {
+    gl_Position = vec4(position * view.xy + view.zw, 0.0, 1.0);
+}
+)";
+    static constexpr const char* ColorFragmentShader = R"(#version 120
+uniform vec4 color;
+void main() {
+    gl_FragColor = color;
+}
+)";
+    static constexpr const char* CircleVertexShader = R"(#version 120
+attribute vec2 corner;
+attribute vec2 center;
+uniform vec4 view;
+uniform float radius;
+varying vec2 local;
+void main() {
+    local = corner;
+    gl_Position = vec4((center + corner * radius) * view.xy + view.zw, 0.0, 1.0);
+}
+)";
+    // круг вырезается из квадрата в шейдере, край сглаживается на ширину пикселя
+    static constexpr const char* CircleFragmentShader = R"(#version 120
+uniform vec4 color;
+varying vec2 local;
+void main() {
+    float d = length(local);
+    float edge = fwidth(d);
+    float alpha = 1.0 - smoothstep(1.0 - edge, 1.0 + edge, d);
+    if (alpha <= 0.0) discard;
+    gl_FragColor = vec4(color.rgb, color.a * alpha);
+}
+)";
+
+    static void SetView(const GlExt& gl, GLuint program, const ViewTransform& view) {
+        gl.Uniform4f(gl.GetUniformLocation(program, "view"), view.scaleX, view.scaleY, view.offsetX, view.offsetY);
+    }
+    static void SetColor(const GlExt& gl, GLuint program, float r, float g, float b) {
+        gl.Uniform4f(gl.GetUniformLocation(program, "color"), r, g, b, 1.0f);
+    }
+
+public:
+    GpuGeometry() = default;
+    GpuGeometry(const GpuGeometry&) = delete;
+    GpuGeometry& operator=(const GpuGeometry&) = delete;
+
+    bool Ready() const { return edgeProgram_ && circleProgram_; }
+
+    // false - контекст не умеет шейдеры/экземпляры, рисовать придется в immediate mode
+    bool Upload(const GlExt& gl, const std::vector<DrawVertex>& vertices, const std::vector<EdgeSegment>& segments) {
+        Release();
+        gl_ = gl;
+        if (!gl_.HasInstancedShaders()) return false;
+        edgeProgram_ = BuildProgram(gl_, EdgeVertexShader, ColorFragmentShader, {"position"});
+        circleProgram_ = BuildProgram(gl_, CircleVertexShader, CircleFragmentShader, {"corner", "center"});
+        if (!Ready()) {
+            Release();
+            return false;
+        }
+
+        std::vector<float> lines;
+        lines.reserve(segments.size() * 4);
+        for (const EdgeSegment& e : segments) lines.insert(lines.end(), {e.x0, e.y0, e.x1, e.y1});
+        std::vector<float> centers;
+        centers.reserve(vertices.size() * 2);
+        for (const DrawVertex& v : vertices) centers.insert(centers.end(), {v.x, v.y});
+        static constexpr float corners[] = {-1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f};
+
+        GLuint buffers[3];
+        gl_.GenBuffers(3, buffers);
+        edgeBuffer_ = buffers[0];
+        cornerBuffer_ = buffers[1];
+        centerBuffer_ = buffers[2];
+        auto upload = [&](GLuint buffer, const void* data, std::size_t bytes) {
+            gl_.BindBuffer(GL_ARRAY_BUFFER, buffer);
+            gl_.BufferData(GL_ARRAY_BUFFER, static_cast<std::ptrdiff_t>(bytes), data, GL_STATIC_DRAW);
+        };
+        upload(edgeBuffer_, lines.data(), lines.size() * sizeof(float));
+        upload(cornerBuffer_, corners, sizeof(corners));
+        upload(centerBuffer_, centers.data(), centers.size() * sizeof(float));
+        gl_.BindBuffer(GL_ARRAY_BUFFER, 0);
+        edgeVertices_ = static_cast<GLsizei>(segments.size() * 2);
+        circles_ = static_cast<GLsizei>(vertices.size());
+        return true;
+    }
+
+    // освобождение видеопамяти; вызывать при живом контексте
+    void Release() {
+        if (edgeBuffer_) {
+            const GLuint buffers[3] = {edgeBuffer_, cornerBuffer_, centerBuffer_};
+            gl_.DeleteBuffers(3, buffers);
+        }
+        if (edgeProgram_) gl_.DeleteProgram(edgeProgram_);
+        if (circleProgram_) gl_.DeleteProgram(circleProgram_);
+        edgeBuffer_ = cornerBuffer_ = centerBuffer_ = 0;
+        edgeProgram_ = circleProgram_ = 0;
+        edgeVertices_ = circles_ = 0;
+    }
+
+    // lineIndices - номера концов видимых отрезков (2s, 2s + 1); nullptr - рисуются все ребра
+    void DrawEdges(const ViewTransform& view, float r, float g, float b,
+                   const std::vector<GLuint>* lineIndices = nullptr) const {
+        if (lineIndices && lineIndices->empty()) return;
+        gl_.UseProgram(edgeProgram_);
+        SetView(gl_, edgeProgram_, view);
+        SetColor(gl_, edgeProgram_, r, g, b);
+        gl_.BindBuffer(GL_ARRAY_BUFFER, edgeBuffer_);
+        gl_.EnableVertexAttribArray(0);
+        gl_.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+        // индексы берутся из памяти процесса (контекст совместимости): их немного, и они меняются вместе с камерой
+        if (lineIndices) glDrawElements(GL_LINES, static_cast<GLsizei>(lineIndices->size()), GL_UNSIGNED_INT, lineIndices->data());
+        else glDrawArrays(GL_LINES, 0, edgeVertices_);
+        gl_.DisableVertexAttribArray(0);
+        gl_.BindBuffer(GL_ARRAY_BUFFER, 0);
+        gl_.UseProgram(0);
+    }
+
+    // все круги одного радиуса - один вызов с экземплярами; centers (x, y) - только видимые, nullptr - все
+    void DrawCircles(const ViewTransform& view, float radius, float r, float g, float b,
+                     const std::vector<float>* centers = nullptr) const {
+        const GLsizei count = centers ? static_cast<GLsizei>(centers->size() / 2) : circles_;
+        if (count == 0) return;
+        gl_.UseProgram(circleProgram_);
+        SetView(gl_, circleProgram_, view);
+        SetColor(gl_, circleProgram_, r, g, b);
+        gl_.Uniform1f(gl_.GetUniformLocation(circleProgram_, "radius"), radius);
+        gl_.BindBuffer(GL_ARRAY_BUFFER, cornerBuffer_);
+        gl_.EnableVertexAttribArray(0);
+        gl_.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+        gl_.BindBuffer(GL_ARRAY_BUFFER, centers ? 0 : centerBuffer_);
+        gl_.EnableVertexAttribArray(1);
+        gl_.VertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, centers ? centers->data() : nullptr);
+        gl_.VertexAttribDivisor(1, 1);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        gl_.DrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+        glDisable(GL_BLEND);
+        gl_.VertexAttribDivisor(1, 0);
+        gl_.DisableVertexAttribArray(1);
+        gl_.DisableVertexAttribArray(0);
+        gl_.BindBuffer(GL_ARRAY_BUFFER, 0);
+        gl_.UseProgram(0);
+    }
+};
+
+#endif //AUTOLABA_GPUGEOMETRY_H
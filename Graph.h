@@ -0,0 +1,122 @@
+#ifndef AUTOLABA_GRAPH_H
+#define AUTOLABA_GRAPH_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "HasseBuilder.h"
+
+// диаграмма Хассе в формате CSR: исходящие и входящие ребра каждой вершины лежат подряд
+struct HasseGraph {
+    int n = 0;
+    std::vector<int> outOffsets; // n + 1
+    std::vector<int> outTargets;
+    std::vector<int> inOffsets;  // n + 1
+    std::vector<int> inSources;
+
+    static HasseGraph FromEdges(const int n, const std::vector<HasseBuilder::Edge>& edges) {
+        HasseGraph g;
+        g.n = n;
+        g.outOffsets.assign(n + 1, 0);
+        g.inOffsets.assign(n + 1, 0);
+        for (const auto& [u, v] : edges) {
+            ++g.outOffsets[u + 1];
+            ++g.inOffsets[v + 1];
+        }
+        for (int i = 0; i < n; ++i) {
+            g.outOffsets[i + 1] += g.outOffsets[i];
+            g.inOffsets[i + 1] += g.inOffsets[i];
+        }
+        g.outTargets.resize(edges.size());
+        g.inSources.resize(edges.size());
+        std::vector<int> outPos(g.outOffsets.begin(), g.outOffsets.end() - 1);
+        std::vector<int> inPos(g.inOffsets.begin(), g.inOffsets.end() - 1);
+        for (const auto& [u, v] : edges) {
+            g.outTargets[outPos[u]++] = v;
+            g.inSources[inPos[v]++] = u;
+        }
+        SortRows(g.outOffsets, g.outTargets);
+        SortRows(g.inOffsets, g.inSources);
+        return g;
+    }
+
+    // соседи каждой вершины по возрастанию, повторное ребро (одна пара введена дважды) остается одно
+    static void SortRows(std::vector<int>& offsets, std::vector<int>& targets) {
+        int size = 0;
+        for (std::size_t i = 0; i + 1 < offsets.size(); ++i) {
+            const int begin = offsets[i], end = offsets[i + 1];
+            std::sort(targets.begin() + begin, targets.begin() + end);
+            offsets[i] = size;
+            for (int k = begin; k < end; ++k) {
+                if (k == begin || targets[k] != targets[k - 1]) targets[size++] = targets[k];
+            }
+        }
+        offsets.back() = size;
+        targets.resize(size);
+    }
+
+    int EdgeCount() const { return static_cast<int>(outTargets.size()); }
+    int OutDegree(int v) const { return outOffsets[v + 1] - outOffsets[v]; }
+    int InDegree(int v) const { return inOffsets[v + 1] - inOffsets[v]; }
+    std::span<const int> Out(int v) const { return {outTargets.data() + outOffsets[v], static_cast<std::size_t>(OutDegree(v))}; }
+    std::span<const int> In(int v) const { return {inSources.data() + inOffsets[v], static_cast<std::size_t>(InDegree(v))}; }
+};
+
+// транзитивное замыкание в виде битовых строк: бит v строки u означает u <= v
+struct Reachability {
+    int n = 0;
+    int words = 0;
+    std::vector<std::uint64_t> bits;
+
+    static Reachability FromGraph(const HasseGraph& g) {
+        Reachability r;
+        r.n = g.n;
+        r.words = (g.n + 63) / 64;
+        r.bits.assign(static_cast<std::size_t>(r.n) * r.words, 0);
+
+        // строки заполняются в обратном топологическом порядке: строка u = {u} | строки всех покрытий u
+        std::vector<int> outdeg(g.n);
+        std::vector<int> queue;
+        queue.reserve(g.n);
+        for (int v = 0; v < g.n; ++v) {
+            outdeg[v] = g.OutDegree(v);
+            if (outdeg[v] == 0) queue.push_back(v);
+        }
+        for (std::size_t head = 0; head < queue.size(); ++head) {
+            const int v = queue[head];
+            std::uint64_t* row = r.Row(v);
+            row[v / 64] |= std::uint64_t{1} << (v % 64);
+            for (int w : g.Out(v)) {
+                const std::uint64_t* other = r.Row(w);
+                for (int k = 0; k < r.words; ++k) row[k] |= other[k];
+            }
+            for (int u : g.In(v)) {
+                if (--outdeg[u] == 0) queue.push_back(u);
+            }
+        }
+        return r;
+    }
+
+    // замыкание занимает n * n / 8 байт, поэтому для графов больше MaxVertices (32 МБ) оно не строится:
+    // вызывающие получают nullopt и обходят CSR (PosetInspector), а в .hsg и статистику оно не попадает
+    static constexpr int MaxVertices = 1 << 14;
+    static std::optional<Reachability> FromGraphIfSmall(const HasseGraph& g) {
+        if (g.n > MaxVertices) return std::nullopt;
+        return FromGraph(g);
+    }
+
+    std::uint64_t* Row(int u) { return bits.data() + static_cast<std::size_t>(u) * words; }
+    const std::uint64_t* Row(int u) const { return bits.data() + static_cast<std::size_t>(u) * words; }
+    bool Reaches(int u, int v) const { return (Row(u)[v / 64] >> (v % 64)) & 1u; }
+    int UpSetSize(int u) const {
+        int count = 0;
+        for (int k = 0; k < words; ++k) count += std::popcount(Row(u)[k]);
+        return count;
+    }
+};
+
+#endif //AUTOLABA_GRAPH_H
@@ -0,0 +1,230 @@
+#ifndef AUTOLABA_GRAPHFILE_H
+#define AUTOLABA_GRAPHFILE_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Graph.h"
+#include "MappedFile.h"
+
+/*
+ * Бинарный вывод диаграммы Хассе (.hsg), little-endian, секции выровнены по 8 байт:
+ *   GraphFileHeader;
+ *   outIndex  - uint64[n + 1], байтовые смещения списков исходящих ребер в outData;
+ *   outData   - для каждой вершины отсортированные цели в виде varint-дельт (первая дельта от 0);
+ *   inIndex, inData - то же для входящих ребер;
+ *   levels    - int32[n];
+ *   reach     - uint64[n * reachWords] битовые строки замыкания (если есть флаг REACH).
+ * Индексы позволяют читателю после mmap декодировать соседей любой вершины независимо.
+ */
+struct GraphFileHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t flags;
+    std::uint32_t reachWords;
+    std::uint64_t n;
+    std::uint64_t edgeCount;
+    std::uint64_t outIndexOffset;
+    std::uint64_t outDataOffset;
+    std::uint64_t outDataSize;
+    std::uint64_t inIndexOffset;
+    std::uint64_t inDataOffset;
+    std::uint64_t inDataSize;
+    std::uint64_t levelsOffset;
+    std::uint64_t reachOffset;
+};
+
+inline constexpr char GraphFileMagic[4] = {'H', 'S', 'G', 'R'};
+inline constexpr std::uint32_t GraphFileVersion = 1;
+inline constexpr std::uint32_t GraphFileReach = 1u << 0;
+
+inline void PutVarint(std::vector<unsigned char>& out, std::uint32_t x) {
+    while (x >= 0x80) {
+        out.push_back(static_cast<unsigned char>(x | 0x80));
+        x >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(x));
+}
+// чтение не дальше end; false - число обрывается на конце секции или длиннее 32 бит
+inline bool GetVarint(const unsigned char*& p, const unsigned char* end, std::uint32_t& x) {
+    x = 0;
+    for (int shift = 0; shift < 35 && p < end; shift += 7) {
+        const unsigned char b = *p++;
+        x |= static_cast<std::uint32_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return shift < 28 || (b >> 4) == 0;
+    }
+    return false;
+}
+
+// кодирование одной стороны CSR: отсортированные списки соседей -> индекс + сжатые дельты
+inline void EncodeAdjacency(const std::vector<int>& offsets, const std::vector<int>& targets,
+                            std::vector<std::uint64_t>& index, std::vector<unsigned char>& data) {
+    const int n = static_cast<int>(offsets.size()) - 1;
+    index.assign(n + 1, 0);
+    data.clear();
+    data.reserve(targets.size() * 2);
+    for (int v = 0; v < n; ++v) {
+        index[v] = data.size();
+        int prev = 0;
+        for (int k = offsets[v]; k < offsets[v + 1]; ++k) {
+            PutVarint(data, static_cast<std::uint32_t>(targets[k] - prev));
+            prev = targets[k];
+        }
+    }
+    index[n] = data.size();
+}
+
+inline void WriteGraphFile(const std::string& path, const HasseGraph& g, const std::vector<int>& levels,
+                           const Reachability* reach = nullptr) {
+    std::vector<std::uint64_t> outIndex, inIndex;
+    std::vector<unsigned char> outData, inData;
+    EncodeAdjacency(g.outOffsets, g.outTargets, outIndex, outData);
+    EncodeAdjacency(g.inOffsets, g.inSources, inIndex, inData);
+
+    auto align8 = [](std::uint64_t x) { return (x + 7) & ~std::uint64_t{7}; };
+    const std::uint64_t n = g.n;
+    GraphFileHeader header {};
+    std::memcpy(header.magic, GraphFileMagic, sizeof(header.magic));
+    header.version = GraphFileVersion;
+    header.flags = reach ? GraphFileReach : 0u;
+    header.reachWords = reach ? static_cast<std::uint32_t>(reach->words) : 0u;
+    header.n = n;
+    header.edgeCount = g.outTargets.size();
+    header.outIndexOffset = align8(sizeof(GraphFileHeader));
+    header.outDataOffset = header.outIndexOffset + (n + 1) * sizeof(std::uint64_t);
+    header.outDataSize = outData.size();
+    header.inIndexOffset = align8(header.outDataOffset + header.outDataSize);
+    header.inDataOffset = header.inIndexOffset + (n + 1) * sizeof(std::uint64_t);
+    header.inDataSize = inData.size();
+    header.levelsOffset = align8(header.inDataOffset + header.inDataSize);
+    header.reachOffset = reach ? align8(header.levelsOffset + n * sizeof(std::int32_t)) : 0;
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out) throw std::runtime_error("Cannot write file: " + path);
+    auto writeAt = [&out](std::uint64_t offset, const void* p, std::size_t size) {
+        const auto pos = static_cast<std::uint64_t>(out.tellp());
+        static constexpr char zeros[8] = {};
+        out.write(zeros, static_cast<std::streamsize>(offset - pos));
+        out.write(static_cast<const char*>(p), static_cast<std::streamsize>(size));
+    };
+    writeAt(0, &header, sizeof(header));
+    writeAt(header.outIndexOffset, outIndex.data(), outIndex.size() * sizeof(std::uint64_t));
+    writeAt(header.outDataOffset, outData.data(), outData.size());
+    writeAt(header.inIndexOffset, inIndex.data(), inIndex.size() * sizeof(std::uint64_t));
+    writeAt(header.inDataOffset, inData.data(), inData.size());
+    writeAt(header.levelsOffset, levels.data(), levels.size() * sizeof(std::int32_t));
+    if (reach) writeAt(header.reachOffset, reach->bits.data(), reach->bits.size() * sizeof(std::uint64_t));
+    if (!out) throw std::runtime_error("Cannot write file: " + path);
+}
+
+// чтение .hsg через mmap для последующих инструментов
+class GraphFile {
+private:
+    MappedFile file_;
+    GraphFileHeader header_ {};
+    const std::uint64_t* outIndex_ = nullptr;
+    const unsigned char* outData_ = nullptr;
+    const std::uint64_t* inIndex_ = nullptr;
+    const unsigned char* inData_ = nullptr;
+    const std::int32_t* levels_ = nullptr;
+    const std::uint64_t* reach_ = nullptr;
+
+    void Fail(const std::string& what) const {
+        throw std::runtime_error("Bad graph file: " + what);
+    }
+
+    // индекс и списки проверены в конструкторе, поэтому здесь чтение только в пределах списка v
+    template <class F>
+    static void Decode(const std::uint64_t* index, const unsigned char* data, int v, F&& f) {
+        const unsigned char* p = data + index[v];
+        const unsigned char* end = data + index[v + 1];
+        std::uint32_t prev = 0, delta = 0;
+        while (p < end && GetVarint(p, end, delta)) {
+            prev += delta;
+            f(static_cast<int>(prev));
+        }
+    }
+
+    // один проход по стороне CSR при открытии: смещения растут и не выходят за секцию, каждое число
+    // читается целиком внутри своего списка, соседи - вершины графа по возрастанию
+    void Validate(const std::uint64_t* index, const unsigned char* data, std::uint64_t dataSize, const char* what) const {
+        const std::uint64_t n = header_.n;
+        if (index[0] != 0 || index[n] != dataSize) Fail(what);
+        for (std::uint64_t v = 0; v < n; ++v) {
+            if (index[v] > index[v + 1] || index[v + 1] > dataSize) Fail(what);
+            const unsigned char* p = data + index[v];
+            const unsigned char* end = data + index[v + 1];
+            std::uint64_t prev = 0;
+            bool first = true;
+            while (p < end) {
+                std::uint32_t delta = 0;
+                if (!GetVarint(p, end, delta)) Fail(what);
+                if (!first && delta == 0) Fail(what);
+                prev += delta;
+                first = false;
+                if (prev >= n) Fail(what);
+            }
+        }
+    }
+
+public:
+    explicit GraphFile(const std::string& path) : file_(path) {
+        const std::uint64_t size = file_.Size();
+        if (size < sizeof(GraphFileHeader)) Fail("too small");
+        std::memcpy(&header_, file_.Data(), sizeof(header_));
+        if (std::memcmp(header_.magic, GraphFileMagic, sizeof(header_.magic)) != 0) Fail("wrong magic");
+        if (header_.version != GraphFileVersion) Fail("unsupported version");
+
+        // n не доверяется: сначала сравнивается с размером файла, только потом умножается на ширину записи
+        const std::uint64_t n = header_.n;
+        if (n >= size / sizeof(std::uint64_t) || n > static_cast<std::uint64_t>(std::numeric_limits<int>::max())) Fail("vertex count");
+        auto inside = [size](std::uint64_t offset, std::uint64_t length) {
+            return offset % 8 == 0 && offset <= size && length <= size - offset;
+        };
+        auto insideBytes = [size](std::uint64_t offset, std::uint64_t length) {
+            return offset <= size && length <= size - offset;
+        };
+        if (!inside(header_.outIndexOffset, (n + 1) * sizeof(std::uint64_t))) Fail("out index");
+        if (!insideBytes(header_.outDataOffset, header_.outDataSize)) Fail("out data");
+        if (!inside(header_.inIndexOffset, (n + 1) * sizeof(std::uint64_t))) Fail("in index");
+        if (!insideBytes(header_.inDataOffset, header_.inDataSize)) Fail("in data");
+        if (!inside(header_.levelsOffset, n * sizeof(std::int32_t))) Fail("levels");
+        if (HasReachability()) {
+            // строка замыкания - ровно n бит, иначе Reaches() выходит за строку
+            if (header_.reachWords != (n + 63) / 64) Fail("reachability");
+            if (n > 0 && header_.reachWords > size / sizeof(std::uint64_t) / n) Fail("reachability");
+            if (!inside(header_.reachOffset, n * header_.reachWords * sizeof(std::uint64_t))) Fail("reachability");
+        }
+
+        const unsigned char* base = file_.Data();
+        outIndex_ = reinterpret_cast<const std::uint64_t*>(base + header_.outIndexOffset);
+        outData_ = base + header_.outDataOffset;
+        inIndex_ = reinterpret_cast<const std::uint64_t*>(base + header_.inIndexOffset);
+        inData_ = base + header_.inDataOffset;
+        levels_ = reinterpret_cast<const std::int32_t*>(base + header_.levelsOffset);
+        if (HasReachability()) reach_ = reinterpret_cast<const std::uint64_t*>(base + header_.reachOffset);
+        Validate(outIndex_, outData_, header_.outDataSize, "out adjacency");
+        Validate(inIndex_, inData_, header_.inDataSize, "in adjacency");
+    }
+
+    int VertexCount() const { return static_cast<int>(header_.n); }
+    std::uint64_t EdgeCount() const { return header_.edgeCount; }
+    bool HasReachability() const { return (header_.flags & GraphFileReach) != 0; }
+    int Level(int v) const { return levels_[v]; }
+    std::span<const std::int32_t> Levels() const { return {levels_, static_cast<std::size_t>(header_.n)}; }
+
+    template <class F> void ForEachOut(int v, F&& f) const { Decode(outIndex_, outData_, v, f); }
+    template <class F> void ForEachIn(int v, F&& f) const { Decode(inIndex_, inData_, v, f); }
+
+    bool Reaches(int u, int v) const {
+        return (reach_[static_cast<std::size_t>(u) * header_.reachWords + v / 64] >> (v % 64)) & 1u;
+    }
+};
+
+#endif //AUTOLABA_GRAPHFILE_H
@@ -3,144 +3,94 @@
 
 #include <vector>
 #include <utility>
-#include <string>
-#include <sstream>
-#include <map>
+
+#include "Parallel.h"
 
 class HasseBuilder {
+public:
+    using Edge = std::pair<int,int>;
+
+    // память построения, которую можно переиспользовать между запусками (пакетный режим)
+    struct Workspace {
+        std::vector<char> le;                 // матрица отношения n x n, строка i - элементы >= i
+        std::vector<std::vector<Edge>> rows;  // ребра, найденные для каждой строки
+    };
+
 private:
-    static void TransitiveClosure(std::vector<std::vector<char>>& le) {
-        const int n = static_cast<int>(le.size());
+    static void TransitiveClosure(std::vector<char>& le, const int n) {
         for (int k = 0; k < n; ++k) {
+            const char* rowK = le.data() + static_cast<std::size_t>(k) * n;
             for (int i = 0; i < n; ++i) {
-                if (!le[i][k]) continue;
+                char* rowI = le.data() + static_cast<std::size_t>(i) * n;
+                if (!rowI[k]) continue;
                 for (int j = 0; j < n; ++j) {
-                    if (le[k][j]) le[i][j] = 1;
+                    if (rowK[j]) rowI[j] = 1;
                 }
             }
         }
     }
-    static std::string EscapeDot(const std::string& s) {
-        std::string r;
-        r.reserve(s.size());
-        for (char c : s) {
-            if (c == '\\' || c == '\"') r.push_back('\\');
-            r.push_back(c);
-        }
-        return r;
-    }
 
 public:
-    using Edge = std::pair<int,int>;
-
-    static std::vector<Edge> BuildHasseEdges(const std::vector<Element>& elements, const Rules& rules) {
-        const int n = static_cast<int>(elements.size());
-        if (n == 0) return {};
-
-        std::vector<std::vector<char>> le(n, std::vector<char>(n, 0));
-        for (int i = 0; i < n; ++i) le[i][i] = 1;
-
-        for (int i = 0; i < n; ++i) {
-            for (int j = 0; j < n; ++j) {
-                if (i == j) continue;
-                const auto cmp = rules.Compare(elements[i], elements[j]);
-                if (cmp == Rules::Cmp::Less || cmp == Rules::Cmp::Equal) {
-                    le[i][j] = 1;
-                } else if (cmp == Rules::Cmp::Greater) {
-                    le[j][i] = 1;
-                }
+    static std::vector<Edge> BuildHasseEdges(const std::vector<Element>& elements, const Rules& rules, int threads = 1) {
+        return BuildHasseEdges(static_cast<int>(elements.size()), [&](int i, int j) {
+            return rules.Compare(elements[i], elements[j]);
+        }, threads);
+    }
+    // построение по произвольному источнику элементов: compare(i, j) возвращает Rules::Cmp для i-го и j-го
+    template <class Compare>
+    static std::vector<Edge> BuildHasseEdges(const int n, Compare&& compare, int threads = 1) {
+        Workspace ws;
+        std::vector<Edge> edges;
+        BuildHasseEdges(n, compare, edges, ws, threads);
+        return edges;
+    }
+    // то же с внешней памятью; сравнения и поиск покрытий идут в threads потоков
+    template <class Compare>
+    static void BuildHasseEdges(const int n, Compare&& compare, std::vector<Edge>& edges, Workspace& ws, int threads = 1) {
+        edges.clear();
+        if (n == 0) return;
+
+        std::vector<char>& le = ws.le;
+        le.assign(static_cast<std::size_t>(n) * n, 0);
+        auto at = [&le, n](int i, int j) -> char& { return le[static_cast<std::size_t>(i) * n + j]; };
+        for (int i = 0; i < n; ++i) at(i, i) = 1;
+
+        // пара (i, j), i < j, обрабатывается потоком строки i: он один пишет и le[i][j], и le[j][i]
+        ParallelFor(0, n, threads, [&](int i) {
+            for (int j = i + 1; j < n; ++j) {
+                const auto ij = compare(i, j);
+                const auto ji = compare(j, i);
+                if (ij == Rules::Cmp::Less || ij == Rules::Cmp::Equal || ji == Rules::Cmp::Greater) at(i, j) = 1;
+                if (ji == Rules::Cmp::Less || ji == Rules::Cmp::Equal || ij == Rules::Cmp::Greater) at(j, i) = 1;
             }
-        }
+        });
 
-        TransitiveClosure(le);
+        TransitiveClosure(le, n);
 
-        std::vector<Edge> edges;
-        edges.reserve(n * 2);
-
-        for (int i = 0; i < n; ++i) {
+        ws.rows.resize(n);
+        ParallelFor(0, n, threads, [&](int i) {
+            std::vector<Edge>& row = ws.rows[i];
+            row.clear();
             for (int j = 0; j < n; ++j) {
                 if (i == j) continue;
 
-                if (!le[i][j] || le[j][i]) continue;
+                if (!at(i, j) || at(j, i)) continue;
 
                 bool has_middle = false;
                 for (int k = 0; k < n; ++k) {
                     if (k == i || k == j) continue;
-                    if (le[i][k] && le[k][j] && !(le[k][i] && le[i][k]) && !(le[j][k] && le[k][j])) {
+                    if (at(i, k) && at(k, j) && !(at(k, i) && at(i, k)) && !(at(j, k) && at(k, j))) {
                         has_middle = true;
                         break;
                     }
                 }
-                if (!has_middle) edges.emplace_back(i, j);
-            }
-        }
-
-        return edges;
-    }
-    // разделение вершин на уровни для удобства красивой визуализации
-    static std::map<int, std::vector<int>> levelIndex(const std::vector<Edge> &edges, const std::vector<Element>& elements) {
-        const int n = static_cast<int>(elements.size());
-
-        std::vector<std::vector<int>> adj(n);
-        std::vector<int> indeg(n, 0);
-        for (auto& e : edges) {
-            adj[e.first].push_back(e.second);
-            indeg[e.second]++;
-        }
-        std::queue<int> q;
-        std::vector<int> level(n, 0);
-
-        for (int i = 0; i < n; ++i)
-            if (indeg[i] == 0)
-                q.push(i);
-
-        while (!q.empty()) {
-            int u = q.front(); q.pop();
-            for (int v : adj[u]) {
-                level[v] = std::max(level[v], level[u] + 1);
-                if (--indeg[v] == 0)
-                    q.push(v);
+                if (!has_middle) row.emplace_back(i, j);
             }
-        }
-        std::map<int, std::vector<int>> result;
-        for (int i = 0; i < n; ++i)
-            result[level[i]].push_back(i);
-        return result;
-    }
-    static std::string ToDot(const std::vector<Element>& elements, const std::vector<Edge>& edges) {
-        std::ostringstream out;
-        out << "digraph Hasse {\n";
-        out << "  rankdir=BT;\n";
-        out << "  node [shape=circle];\n";
-
-        for (int i = 0; i < (int)elements.size(); ++i) {
-            out << "  n" << i << " [label=\"" << EscapeDot(elements[i].ToString()) << "\"];\n";
-        }
-
-        for (const auto& [u, v] : edges) {
-            out << "  n" << u << " -> n" << v << ";\n";
-        }
+        });
 
-        // вывод экстремальных характеристик
-        std::map<int, std::vector<int>> levels = levelIndex(edges, elements);
-        out << "}\n\nExtreme characteristics:\nMinimal elements: [";
-        for (int i = 0; i < levels[0].size() - 1; i++) {
-            out << elements[levels[0][i]].ToString() << ", ";
-        }
-        out << elements[levels[0][levels[0].size() - 1]].ToString() << "]\nMaximal elements: [";
-        for (int i = 0; i < levels[static_cast<int>(levels.size()) - 1].size() - 1; i++) {
-            out << elements[levels[static_cast<int>(levels.size()) - 1][i]].ToString() << ", ";
-        }
-        out << elements[levels[static_cast<int>(levels.size()) - 1][levels[static_cast<int>(levels.size()) - 1].size() - 1]].ToString() << "]\nHeight: ";
-        out << static_cast<int>(levels.size()) << "\nWidth: ";
-        int maxWidth = 0;
-        for (const auto& [lvl, vec] : levels) {
-            if (vec.size() > maxWidth)
-                maxWidth = static_cast<int>(vec.size());
-        }
-        out << maxWidth;
-        return out.str();
+        edges.reserve(n * 2);
+        for (int i = 0; i < n; ++i) edges.insert(edges.end(), ws.rows[i].begin(), ws.rows[i].end());
     }
 };
 
-#endif //AUTOLABA_HASSEBUILDER_H
\ No newline at end of file
+#endif //AUTOLABA_HASSEBUILDER_H
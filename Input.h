@@ -5,6 +5,7 @@
 #include <vector>
 #include <sstream>
 #include <stdexcept>
+#include <unordered_map>
 
 enum class InputMode { INT, STRING, SET_INT };
 
@@ -44,8 +45,9 @@ static Element ParseElementFromLine(InputMode mode, const std::string& rawLine)
     return Element(std::move(v));
 }
 
-static std::vector<Element> ReadElementsFromLines(std::istream& in, InputMode mode) {
-    std::vector<Element> elements;
+// чтение в уже выделенный вектор (его емкость сохраняется между файлами)
+static void ReadElementsFromLines(std::istream& in, InputMode mode, std::vector<Element>& elements) {
+    elements.clear();
     std::string line;
 
     while (true) {
@@ -56,9 +58,38 @@ static std::vector<Element> ReadElementsFromLines(std::istream& in, InputMode mo
     }
 
     if (elements.empty()) throw std::runtime_error("No elements were provided");
+}
+
+static std::vector<Element> ReadElementsFromLines(std::istream& in, InputMode mode) {
+    std::vector<Element> elements;
+    ReadElementsFromLines(in, mode, elements);
     return elements;
 }
 
+// удаление повторов с сохранением порядка первых вхождений, возвращает число удаленных
+static int DeduplicateStable(std::vector<Element>& elements) {
+    std::unordered_multimap<std::uint64_t, std::size_t> seen;
+    seen.reserve(elements.size());
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < elements.size(); ++i) {
+        const std::uint64_t h = elements[i].Hash();
+        bool duplicate = false;
+        auto [first, last] = seen.equal_range(h);
+        for (auto it = first; it != last; ++it) {
+            if (elements[it->second] == elements[i]) {
+                duplicate = true;
+                break;
+            }
+        }
+        if (duplicate) continue;
+        if (kept != i) elements[kept] = std::move(elements[i]);
+        seen.emplace(h, kept++);
+    }
+    const int removed = static_cast<int>(elements.size() - kept);
+    elements.resize(kept);
+    return removed;
+}
+
 static Element::Type ModeToElementType(InputMode mode) {
     if (mode == InputMode::INT) return Element::Type::INT;
     if (mode == InputMode::STRING) return Element::Type::STRING;
@@ -0,0 +1,53 @@
+#ifndef AUTOLABA_INSPECT_H
+#define AUTOLABA_INSPECT_H
+
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+#include "Graph.h"
+
+// сведения о выбранной вершине: покрытия берутся из CSR, верхнее и нижнее множества считаются только по запросу
+class PosetInspector {
+private:
+    const HasseGraph& graph_;
+    const Reachability* reach_;
+    std::vector<char> seen_; // отметки обхода; после обхода сбрасываются только посещенные вершины
+
+    // обход от v по покрытиям вверх или вниз: работа пропорциональна размеру ответа и его ребрам
+    std::vector<int> Walk(int v, bool up) {
+        if (seen_.size() != static_cast<std::size_t>(graph_.n)) seen_.assign(graph_.n, 0);
+        std::vector<int> result {v};
+        seen_[v] = 1;
+        for (std::size_t head = 0; head < result.size(); ++head) {
+            for (int w : up ? graph_.Out(result[head]) : graph_.In(result[head])) {
+                if (seen_[w]) continue;
+                seen_[w] = 1;
+                result.push_back(w);
+            }
+        }
+        for (int w : result) seen_[w] = 0;
+        return result;
+    }
+
+public:
+    // reach может быть nullptr (для больших графов замыкание не строится)
+    PosetInspector(const HasseGraph& graph, const Reachability* reach) : graph_(graph), reach_(reach) {}
+
+    const HasseGraph& Graph() const { return graph_; }
+
+    // элементы >= v, включая v: строка замыкания, если оно есть, иначе обход вверх
+    std::vector<int> UpSet(int v) {
+        if (!reach_) return Walk(v, true);
+        std::vector<int> result;
+        const std::uint64_t* row = reach_->Row(v);
+        for (int k = 0; k < reach_->words; ++k) {
+            for (std::uint64_t word = row[k]; word; word &= word - 1) result.push_back(k * 64 + std::countr_zero(word));
+        }
+        return result;
+    }
+    // элементы <= v, включая v; строки замыкания хранят только верхние множества, поэтому всегда обход вниз
+    std::vector<int> DownSet(int v) { return Walk(v, false); }
+};
+
+#endif //AUTOLABA_INSPECT_H
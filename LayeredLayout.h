@@ -0,0 +1,452 @@
+#ifndef AUTOLABA_LAYEREDLAYOUT_H
+#define AUTOLABA_LAYEREDLAYOUT_H
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "Graph.h"
+#include "Layering.h"
+#include "Parallel.h"
+
+/*
+ * Послойная раскладка (схема Сугиямы): длинные ребра разбиваются фиктивными узлами так, что каждое ребро
+ * соединяет соседние уровни, затем порядок внутри уровней подбирается проходами барицентра/медианы
+ * с подсчетом пересечений деревом Фенвика. Уровни одной четности переупорядочиваются параллельно.
+ */
+
+struct LayoutOptions {
+    int threads = 1;
+    double timeBudget = 2.0;  // секунд на упорядочивание; 0 - оставить порядок индексов
+    int maxIterations = 64;
+    int patience = 4;         // остановка после стольких итераций без улучшения
+};
+
+// граф с фиктивными узлами: узлы 0..realCount-1 - элементы, остальные - точки излома длинных ребер
+struct LayeredGraph {
+    int realCount = 0;
+    std::vector<int> level;       // уровень каждого узла
+    std::vector<int> order;       // узлы по уровням (как в Layering), внутри уровня - текущий порядок
+    std::vector<int> offsets;     // LevelCount() + 1
+    std::vector<int> position;    // место узла внутри своего уровня
+    std::vector<int> upOffsets;   // соседи уровнем выше, CSR
+    std::vector<int> up;
+    std::vector<int> downOffsets; // соседи уровнем ниже, CSR
+    std::vector<int> down;
+
+    // ребра, идущие вниз по уровням или внутри уровня (возможны только при циклах в ручном вводе), пропускаются
+    static LayeredGraph FromGraph(const HasseGraph& g, const Layering& layering) {
+        LayeredGraph lg;
+        lg.realCount = g.n;
+        lg.level = layering.level;
+        std::vector<std::pair<int, int>> links;
+        links.reserve(g.EdgeCount());
+        for (int u = 0; u < g.n; ++u) {
+            for (int v : g.Out(u)) {
+                if (layering.level[v] <= layering.level[u]) continue;
+                int prev = u;
+                for (int l = layering.level[u] + 1; l < layering.level[v]; ++l) {
+                    const int dummy = static_cast<int>(lg.level.size());
+                    lg.level.push_back(l);
+                    links.emplace_back(prev, dummy);
+                    prev = dummy;
+                }
+                links.emplace_back(prev, v);
+            }
+        }
+        const int nodes = static_cast<int>(lg.level.size());
+
+        // начальный порядок: элементы как в Layering, за ними фиктивные узлы в порядке появления
+        const int levelCount = layering.LevelCount();
+        lg.offsets.assign(levelCount + 1, 0);
+        for (int v = 0; v < nodes; ++v) ++lg.offsets[lg.level[v] + 1];
+        for (int l = 0; l < levelCount; ++l) lg.offsets[l + 1] += lg.offsets[l];
+        lg.order.assign(nodes, 0);
+        std::vector<int> pos(lg.offsets.begin(), lg.offsets.end() - 1);
+        for (int v : layering.order) lg.order[pos[lg.level[v]]++] = v;
+        for (int v = g.n; v < nodes; ++v) lg.order[pos[lg.level[v]]++] = v;
+        lg.position.assign(nodes, 0);
+        for (int l = 0; l < levelCount; ++l)
+            for (int i = lg.offsets[l]; i < lg.offsets[l + 1]; ++i) lg.position[lg.order[i]] = i - lg.offsets[l];
+
+        lg.upOffsets.assign(nodes + 1, 0);
+        lg.downOffsets.assign(nodes + 1, 0);
+        for (const auto& [a, b] : links) {
+            ++lg.upOffsets[a + 1];
+            ++lg.downOffsets[b + 1];
+        }
+        for (int v = 0; v < nodes; ++v) {
+            lg.upOffsets[v + 1] += lg.upOffsets[v];
+            lg.downOffsets[v + 1] += lg.downOffsets[v];
+        }
+        lg.up.resize(links.size());
+        lg.down.resize(links.size());
+        std::vector<int> upPos(lg.upOffsets.begin(), lg.upOffsets.end() - 1);
+        std::vector<int> downPos(lg.downOffsets.begin(), lg.downOffsets.end() - 1);
+        for (const auto& [a, b] : links) {
+            lg.up[upPos[a]++] = b;
+            lg.down[downPos[b]++] = a;
+        }
+        return lg;
+    }
+
+    int NodeCount() const { return static_cast<int>(level.size()); }
+    int LevelCount() const { return static_cast<int>(offsets.size()) - 1; }
+    int LevelSize(int l) const { return offsets[l + 1] - offsets[l]; }
+    std::span<const int> Level(int l) const { return {order.data() + offsets[l], static_cast<std::size_t>(LevelSize(l))}; }
+    std::span<const int> Up(int v) const { return {up.data() + upOffsets[v], static_cast<std::size_t>(upOffsets[v + 1] - upOffsets[v])}; }
+    std::span<const int> Down(int v) const {
+        return {down.data() + downOffsets[v], static_cast<std::size_t>(downOffsets[v + 1] - downOffsets[v])};
+    }
+    bool IsDummy(int v) const { return v >= realCount; }
+};
+
+// пересечения между уровнями l и l + 1: инверсии в последовательности позиций верхних концов (Barth-Jünger-Mutzel)
+inline long long CountLevelCrossings(const LayeredGraph& lg, int l, std::vector<int>& tree, std::vector<int>& ends) {
+    const int size = lg.LevelSize(l + 1);
+    tree.assign(size + 1, 0);
+    long long crossings = 0;
+    long long inserted = 0;
+    for (int v : lg.Level(l)) {
+        ends.clear();
+        for (int w : lg.Up(v)) ends.push_back(lg.position[w]);
+        std::sort(ends.begin(), ends.end());
+        for (int p : ends) {
+            long long notGreater = 0;
+            for (int i = p + 1; i > 0; i -= i & -i) notGreater += tree[i];
+            crossings += inserted - notGreater;
+            for (int i = p + 1; i <= size; i += i & -i) ++tree[i];
+            ++inserted;
+        }
+    }
+    return crossings;
+}
+
+inline long long CountCrossings(const LayeredGraph& lg, int threads = 1) {
+    const int pairs = std::max(0, lg.LevelCount() - 1);
+    std::vector<long long> perLevel(pairs, 0);
+    ParallelFor(0, pairs, threads, [&](int l) {
+        thread_local std::vector<int> tree;
+        thread_local std::vector<int> ends;
+        perLevel[l] = CountLevelCrossings(lg, l, tree, ends);
+    });
+    long long total = 0;
+    for (long long c : perLevel) total += c;
+    return total;
+}
+
+// переупорядочивание одного уровня по ключу соседей; узлы без соседей сохраняют свое относительное место
+inline void ReorderLevel(LayeredGraph& lg, int l, bool useDown, bool useUp, bool median,
+                         std::vector<std::pair<double, int>>& keys, std::vector<double>& values) {
+    const int size = lg.LevelSize(l);
+    keys.clear();
+    for (int v : lg.Level(l)) {
+        values.clear();
+        // позиции нормированы размером уровня, чтобы соседей сверху и снизу можно было смешивать
+        auto collect = [&](std::span<const int> neighbours, int neighbourLevel) {
+            const double scale = 1.0 / std::max(1, lg.LevelSize(neighbourLevel));
+            for (int w : neighbours) values.push_back((lg.position[w] + 0.5) * scale);
+        };
+        if (useDown && l > 0) collect(lg.Down(v), l - 1);
+        if (useUp && l + 1 < lg.LevelCount()) collect(lg.Up(v), l + 1);
+        double key = (lg.position[v] + 0.5) / size;
+        if (!values.empty()) {
+            if (median) {
+                const std::size_t mid = values.size() / 2;
+                std::nth_element(values.begin(), values.begin() + mid, values.end());
+                key = values[mid];
+                if (values.size() % 2 == 0) key = 0.5 * (key + *std::max_element(values.begin(), values.begin() + mid));
+            } else {
+                key = 0.0;
+                for (double x : values) key += x;
+                key /= static_cast<double>(values.size());
+            }
+        }
+        keys.emplace_back(key, v);
+    }
+    std::stable_sort(keys.begin(), keys.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    int* out = lg.order.data() + lg.offsets[l];
+    for (int i = 0; i < size; ++i) {
+        out[i] = keys[i].second;
+        lg.position[out[i]] = i;
+    }
+}
+
+struct OrderingResult {
+    long long initialCrossings = 0;
+    long long crossings = 0;
+    int iterations = 0;
+};
+
+/*
+ * Итерация 0 - последовательные проходы вниз и вверх с односторонним барицентром (быстро сводит порядок).
+ * Дальше - параллельные фазы: сначала все четные уровни по соседям с обеих сторон, потом все нечетные;
+ * барицентр и медиана чередуются. Сохраняется лучший найденный порядок.
+ */
+inline OrderingResult OrderLayers(LayeredGraph& lg, const LayoutOptions& options = {}) {
+    OrderingResult result;
+    result.initialCrossings = result.crossings = CountCrossings(lg, options.threads);
+    if (options.timeBudget <= 0.0 || result.crossings == 0) return result;
+
+    const auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&start]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    const int levelCount = lg.LevelCount();
+    std::vector<int> bestOrder = lg.order;
+    std::vector<int> bestPosition = lg.position;
+    auto keep = [&](long long crossings) {
+        if (crossings >= result.crossings) return false;
+        result.crossings = crossings;
+        bestOrder = lg.order;
+        bestPosition = lg.position;
+        return true;
+    };
+
+    {
+        std::vector<std::pair<double, int>> keys;
+        std::vector<double> values;
+        for (int l = 1; l < levelCount; ++l) ReorderLevel(lg, l, true, false, false, keys, values);
+        for (int l = levelCount - 2; l >= 0; --l) ReorderLevel(lg, l, false, true, false, keys, values);
+        keep(CountCrossings(lg, options.threads));
+        result.iterations = 1;
+    }
+
+    int stale = 0;
+    while (result.iterations < options.maxIterations && stale < options.patience && result.crossings > 0 &&
+           elapsed() < options.timeBudget) {
+        const bool median = result.iterations % 2 == 1;
+        for (int parity = 0; parity < 2; ++parity) {
+            const int phaseLevels = (levelCount - parity + 1) / 2;
+            ParallelFor(0, phaseLevels, options.threads, [&](int k) {
+                thread_local std::vector<std::pair<double, int>> keys;
+                thread_local std::vector<double> values;
+                ReorderLevel(lg, 2 * k + parity, true, true, median, keys, values);
+            });
+        }
+        ++result.iterations;
+        stale = keep(CountCrossings(lg, options.threads)) ? 0 : stale + 1;
+    }
+
+    lg.order = std::move(bestOrder);
+    lg.position = std::move(bestPosition);
+    return result;
+}
+
+/*
+ * Горизонтальные координаты по Брандесу-Кёпфу: четыре раскладки (выравнивание к медианным соседям снизу/сверху,
+ * просмотр слева/справа), в каждой вершины собираются в вертикальные блоки, блоки прижимаются друг к другу
+ * проходом по графу блоков в топологическом порядке. Итог - среднее двух медиан из четырех координат.
+ * Все шаги линейны по числу узлов и звеньев (не считая сортировки коротких списков соседей).
+ */
+
+inline constexpr double RealSeparation = 1.0;   // расстояние между соседними элементами уровня
+inline constexpr double DummySeparation = 0.5;  // если хотя бы один из соседей - фиктивный узел
+
+namespace LayeredDetail {
+
+// соседи узла, отсортированные по месту в уровне; link - номер звена (индекс в down) для пометок конфликтов
+struct SortedNeighbours {
+    std::vector<int> offsets;
+    std::vector<int> node;
+    std::vector<int> link;
+
+    std::span<const int> Nodes(int v) const {
+        return {node.data() + offsets[v], static_cast<std::size_t>(offsets[v + 1] - offsets[v])};
+    }
+    std::span<const int> Links(int v) const {
+        return {link.data() + offsets[v], static_cast<std::size_t>(offsets[v + 1] - offsets[v])};
+    }
+};
+
+inline void SortByPosition(const LayeredGraph& lg, SortedNeighbours& s) {
+    std::vector<std::pair<int, int>> items; // (место соседа, номер звена)
+    for (int v = 0; v < lg.NodeCount(); ++v) {
+        items.clear();
+        for (int k = s.offsets[v]; k < s.offsets[v + 1]; ++k) items.emplace_back(lg.position[s.node[k]], s.link[k]);
+        if (items.size() < 2) continue;
+        std::sort(items.begin(), items.end());
+        const std::span<const int> level = lg.Level(lg.level[s.node[s.offsets[v]]]);
+        for (std::size_t j = 0; j < items.size(); ++j) {
+            s.node[s.offsets[v] + j] = level[items[j].first];
+            s.link[s.offsets[v] + j] = items[j].second;
+        }
+    }
+}
+
+// звено между двумя фиктивными узлами - часть длинного ребра; его пересечения с прочими звеньями
+// помечаются (конфликт 1-го типа), и такие прочие звенья не участвуют в выравнивании
+inline std::vector<char> MarkConflicts(const LayeredGraph& lg, const SortedNeighbours& lower) {
+    std::vector<char> marked(lg.down.size(), 0);
+    for (int l = 1; l + 1 < lg.LevelCount(); ++l) {
+        const std::span<const int> upper = lg.Level(l);
+        const int lastLower = lg.LevelSize(l - 1) - 1;
+        int k0 = 0;
+        int scan = 0;
+        for (int i = 0; i < static_cast<int>(upper.size()); ++i) {
+            const int v = upper[i];
+            int inner = -1;
+            if (lg.IsDummy(v) && lower.Nodes(v).size() == 1 && lg.IsDummy(lower.Nodes(v)[0])) inner = lower.Nodes(v)[0];
+            if (i + 1 != static_cast<int>(upper.size()) && inner < 0) continue;
+            const int k1 = inner >= 0 ? lg.position[inner] : lastLower;
+            for (; scan <= i; ++scan) {
+                const int w = upper[scan];
+                const std::span<const int> nodes = lower.Nodes(w);
+                for (std::size_t j = 0; j < nodes.size(); ++j) {
+                    const int k = lg.position[nodes[j]];
+                    if (k < k0 || k > k1) marked[lower.Links(w)[j]] = 1;
+                }
+            }
+            k0 = k1;
+        }
+    }
+    return marked;
+}
+
+// одна из четырех раскладок: fromBelow - выравнивание к соседям уровнем ниже, leftToRight - направление просмотра
+inline std::vector<double> PlaceBlocks(const LayeredGraph& lg, const SortedNeighbours& lower, const SortedNeighbours& upper,
+                                       const std::vector<char>& marked, bool fromBelow, bool leftToRight) {
+    const int nodes = lg.NodeCount();
+    const int levelCount = lg.LevelCount();
+    std::vector<int> root(nodes);
+    std::vector<int> align(nodes);
+    for (int v = 0; v < nodes; ++v) root[v] = align[v] = v;
+
+    // вертикальное выравнивание: каждая вершина пытается примкнуть к медианному соседу, не пересекая уже выбранные
+    for (int step = 1; step < levelCount; ++step) {
+        const int l = fromBelow ? step : levelCount - 1 - step;
+        const SortedNeighbours& side = fromBelow ? lower : upper;
+        const std::span<const int> level = lg.Level(l);
+        const int size = static_cast<int>(level.size());
+        int r = leftToRight ? -1 : std::numeric_limits<int>::max();
+        for (int i = 0; i < size; ++i) {
+            const int v = level[leftToRight ? i : size - 1 - i];
+            const std::span<const int> ns = side.Nodes(v);
+            const int d = static_cast<int>(ns.size());
+            if (d == 0) continue;
+            const int lowMedian = (d - 1) / 2;
+            const int highMedian = d / 2;
+            for (int m : {leftToRight ? lowMedian : highMedian, leftToRight ? highMedian : lowMedian}) {
+                if (align[v] != v) break;
+                const int u = ns[m];
+                const int p = lg.position[u];
+                if (marked[side.Links(v)[m]] || (leftToRight ? r >= p : r <= p)) continue;
+                align[u] = v;
+                root[v] = root[u];
+                align[v] = root[v];
+                r = p;
+            }
+        }
+    }
+
+    // граф блоков: сосед по уровню в порядке просмотра должен стоять левее на ширину промежутка
+    std::vector<int> edgeOffsets(nodes + 1, 0);
+    for (int l = 0; l < levelCount; ++l) {
+        const std::span<const int> level = lg.Level(l);
+        for (std::size_t i = 1; i < level.size(); ++i) {
+            const int v = leftToRight ? level[i - 1] : level[level.size() - i];
+            ++edgeOffsets[root[v] + 1];
+        }
+    }
+    for (int v = 0; v < nodes; ++v) edgeOffsets[v + 1] += edgeOffsets[v];
+    std::vector<int> edgeTarget(edgeOffsets[nodes]);
+    std::vector<double> edgeGap(edgeOffsets[nodes]);
+    std::vector<int> indegree(nodes, 0);
+    std::vector<int> cursor(edgeOffsets.begin(), edgeOffsets.end() - 1);
+    for (int l = 0; l < levelCount; ++l) {
+        const std::span<const int> level = lg.Level(l);
+        const std::size_t size = level.size();
+        for (std::size_t i = 1; i < size; ++i) {
+            const int before = leftToRight ? level[i - 1] : level[size - i];
+            const int after = leftToRight ? level[i] : level[size - 1 - i];
+            const int k = cursor[root[before]]++;
+            edgeTarget[k] = root[after];
+            edgeGap[k] = lg.IsDummy(before) || lg.IsDummy(after) ? DummySeparation : RealSeparation;
+            ++indegree[root[after]];
+        }
+    }
+
+    // прижатие: самое левое допустимое место каждого блока, топологический порядок (Кан)
+    std::vector<double> blockX(nodes, 0.0);
+    std::vector<int> queue;
+    queue.reserve(nodes);
+    for (int v = 0; v < nodes; ++v)
+        if (root[v] == v && indegree[v] == 0) queue.push_back(v);
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+        const int b = queue[head];
+        for (int k = edgeOffsets[b]; k < edgeOffsets[b + 1]; ++k) {
+            const int t = edgeTarget[k];
+            blockX[t] = std::max(blockX[t], blockX[b] + edgeGap[k]);
+            if (--indegree[t] == 0) queue.push_back(t);
+        }
+    }
+
+    std::vector<double> x(nodes);
+    for (int v = 0; v < nodes; ++v) x[v] = leftToRight ? blockX[root[v]] : -blockX[root[v]];
+    return x;
+}
+
+} // namespace LayeredDetail
+
+// x каждого узла (включая фиктивные) в единицах RealSeparation; порядок внутри уровней сохраняется
+inline std::vector<double> AssignCoordinates(const LayeredGraph& lg) {
+    using namespace LayeredDetail;
+    const int nodes = lg.NodeCount();
+    if (nodes == 0) return {};
+
+    SortedNeighbours lower {lg.downOffsets, lg.down, std::vector<int>(lg.down.size())};
+    for (std::size_t k = 0; k < lg.down.size(); ++k) lower.link[k] = static_cast<int>(k);
+    SortedNeighbours upper {lg.upOffsets, std::vector<int>(lg.up.size()), std::vector<int>(lg.up.size())};
+    {
+        std::vector<int> cursor(lg.upOffsets.begin(), lg.upOffsets.end() - 1);
+        for (int v = 0; v < nodes; ++v) {
+            for (int k = lg.downOffsets[v]; k < lg.downOffsets[v + 1]; ++k) {
+                const int c = cursor[lg.down[k]]++;
+                upper.node[c] = v;
+                upper.link[c] = k;
+            }
+        }
+    }
+    SortByPosition(lg, lower);
+    SortByPosition(lg, upper);
+    const std::vector<char> marked = MarkConflicts(lg, lower);
+
+    std::vector<double> layouts[4];
+    int narrowest = 0;
+    double bestWidth = std::numeric_limits<double>::max();
+    std::pair<double, double> ranges[4];
+    for (int i = 0; i < 4; ++i) {
+        layouts[i] = PlaceBlocks(lg, lower, upper, marked, i < 2, i % 2 == 0);
+        const auto [lo, hi] = std::minmax_element(layouts[i].begin(), layouts[i].end());
+        ranges[i] = {*lo, *hi};
+        if (*hi - *lo < bestWidth) {
+            bestWidth = *hi - *lo;
+            narrowest = i;
+        }
+    }
+    // левые раскладки прижимаются к левому краю самой узкой, правые - к правому
+    for (int i = 0; i < 4; ++i) {
+        const double shift = i % 2 == 0 ? ranges[narrowest].first - ranges[i].first : ranges[narrowest].second - ranges[i].second;
+        for (double& x : layouts[i]) x += shift;
+    }
+
+    std::vector<double> x(nodes);
+    for (int v = 0; v < nodes; ++v) {
+        double c[4] = {layouts[0][v], layouts[1][v], layouts[2][v], layouts[3][v]};
+        std::sort(c, c + 4);
+        x[v] = 0.5 * (c[1] + c[2]);
+    }
+    // усреднение может сблизить соседей: промежутки восстанавливаются одним проходом слева направо
+    for (int l = 0; l < lg.LevelCount(); ++l) {
+        const std::span<const int> level = lg.Level(l);
+        for (std::size_t i = 1; i < level.size(); ++i) {
+            const double gap = lg.IsDummy(level[i - 1]) || lg.IsDummy(level[i]) ? DummySeparation : RealSeparation;
+            x[level[i]] = std::max(x[level[i]], x[level[i - 1]] + gap);
+        }
+    }
+    return x;
+}
+
+#endif //AUTOLABA_LAYEREDLAYOUT_H
@@ -0,0 +1,78 @@
+#ifndef AUTOLABA_LAYERING_H
+#define AUTOLABA_LAYERING_H
+
+#include <algorithm>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "Graph.h"
+
+// разделение вершин на уровни (длина самого длинного пути от минимальных элементов);
+// уровни хранятся плоско: order - вершины уровня 0, затем уровня 1 и т.д., offsets - границы уровней
+struct Layering {
+    std::vector<int> level;   // уровень каждой вершины
+    std::vector<int> order;   // вершины по уровням, внутри уровня по возрастанию индекса
+    std::vector<int> offsets; // LevelCount() + 1
+
+    static Layering FromGraph(const HasseGraph& g) {
+        Layering layering;
+        layering.level.assign(g.n, 0);
+
+        std::vector<int> indeg(g.n);
+        std::vector<int>& queue = layering.order; // очередь Кана переиспользует память order
+        queue.reserve(g.n);
+        for (int v = 0; v < g.n; ++v) {
+            indeg[v] = g.InDegree(v);
+            if (indeg[v] == 0) queue.push_back(v);
+        }
+        for (std::size_t head = 0; head < queue.size(); ++head) {
+            const int u = queue[head];
+            for (int v : g.Out(u)) {
+                layering.level[v] = std::max(layering.level[v], layering.level[u] + 1);
+                if (--indeg[v] == 0) queue.push_back(v);
+            }
+        }
+
+        // сортировка подсчетом по уровню (вершины на циклах остаются на достигнутом уровне)
+        int levelCount = 0;
+        for (int v = 0; v < g.n; ++v) levelCount = std::max(levelCount, layering.level[v] + 1);
+        layering.offsets.assign(levelCount + 1, 0);
+        for (int v = 0; v < g.n; ++v) ++layering.offsets[layering.level[v] + 1];
+        for (int l = 0; l < levelCount; ++l) layering.offsets[l + 1] += layering.offsets[l];
+        queue.assign(g.n, 0);
+        std::vector<int> pos(layering.offsets.begin(), layering.offsets.end() - 1);
+        for (int v = 0; v < g.n; ++v) layering.order[pos[layering.level[v]]++] = v;
+        return layering;
+    }
+
+    int LevelCount() const { return static_cast<int>(offsets.size()) - 1; }
+    int LevelSize(int l) const { return offsets[l + 1] - offsets[l]; }
+    std::span<const int> Level(int l) const { return {order.data() + offsets[l], static_cast<std::size_t>(LevelSize(l))}; }
+    int MaxLevelSize() const {
+        int width = 0;
+        for (int l = 0; l < LevelCount(); ++l) width = std::max(width, LevelSize(l));
+        return width;
+    }
+};
+
+// все, что считается по ребрам один раз после построения: CSR, уровни и (если нужно и граф небольшой) замыкание;
+// дальше их читают и статистика, и экспорт, и отрисовка
+struct HasseStructure {
+    HasseGraph graph;
+    Layering layering;
+    std::optional<Reachability> reach;
+
+    static HasseStructure FromEdges(const int n, const std::vector<HasseBuilder::Edge>& edges, bool withReach = true) {
+        HasseStructure s;
+        s.graph = HasseGraph::FromEdges(n, edges);
+        s.layering = Layering::FromGraph(s.graph);
+        if (withReach) s.reach = Reachability::FromGraphIfSmall(s.graph);
+        return s;
+    }
+
+    // nullptr, если замыкание не строилось
+    const Reachability* Reach() const { return reach ? &*reach : nullptr; }
+};
+
+#endif //AUTOLABA_LAYERING_H
@@ -0,0 +1,102 @@
+#ifndef AUTOLABA_LAYOUT_H
+#define AUTOLABA_LAYOUT_H
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ElementFile.h"
+#include "LayeredLayout.h"
+#include "Layering.h"
+
+// расположение вершин в нормализованном квадрате [-1, 1]; не зависит от GL
+inline float Radius = 0.0f;
+// вершины меньше этого радиуса (в пикселях) рисуются без подписей: текст все равно слился бы
+inline constexpr float MinLabelRadius = 3.0f;
+
+struct DrawVertex {
+    int index = 0;
+    std::string string;
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+// таблица "индекс элемента -> позиция в vertices" (-1, если элемент не нарисован) вместо линейного поиска
+inline std::vector<int> VertexSlots(const std::vector<DrawVertex>& vertices) {
+    int maxIndex = -1;
+    for (const auto& v : vertices) maxIndex = std::max(maxIndex, v.index);
+    std::vector<int> slot(maxIndex + 1, -1);
+    for (int i = 0; i < static_cast<int>(vertices.size()); ++i) slot[vertices[i].index] = i;
+    return slot;
+}
+
+// ребро с уже найденными концами: строится один раз после раскладки, кадр проходит по массиву за O(E)
+struct EdgeSegment {
+    int edge = 0;  // номер ребра в исходном списке
+    int from = 0;  // позиции концов в vertices
+    int to = 0;
+    float x0 = 0.0f;
+    float y0 = 0.0f;
+    float x1 = 0.0f;
+    float y1 = 0.0f;
+};
+// ребра, у которых хотя бы один конец не нарисован, пропускаются
+inline std::vector<EdgeSegment> EdgeGeometry(const std::vector<DrawVertex>& vertices,
+                                             const std::vector<std::pair<int, int>>& edges) {
+    const std::vector<int> slot = VertexSlots(vertices);
+    const int slots = static_cast<int>(slot.size());
+    std::vector<EdgeSegment> segments;
+    segments.reserve(edges.size());
+    for (int i = 0; i < static_cast<int>(edges.size()); ++i) {
+        const auto [u, v] = edges[i];
+        if (u < 0 || v < 0 || u >= slots || v >= slots || slot[u] < 0 || slot[v] < 0) continue;
+        const DrawVertex& parent = vertices[slot[u]];
+        const DrawVertex& child = vertices[slot[v]];
+        segments.push_back(EdgeSegment {i, slot[u], slot[v], parent.x, parent.y, child.x, child.y});
+    }
+    return segments;
+}
+
+// DrawVertex для каждой вершины диаграммы после упорядочивания уровней: x берется из AssignCoordinates,
+// единица расстояния - шаг между элементами
+inline std::vector<DrawVertex> VerticesFromHasse(const ElementList& elements, const LayeredGraph& layered) {
+    const std::vector<double> x = AssignCoordinates(layered);
+    double minX = std::numeric_limits<double>::max();
+    double maxX = std::numeric_limits<double>::lowest();
+    for (int v = 0; v < layered.realCount; ++v) {
+        minX = std::min(minX, x[v]);
+        maxX = std::max(maxX, x[v]);
+    }
+    std::vector<DrawVertex> vertices;
+    vertices.reserve(elements.size());
+    if (layered.realCount == 0) return vertices;
+    // ширина в шагах + поля по шагу с каждой стороны
+    const float xStep = 2.0f / static_cast<float>(maxX - minX + 2.0 * RealSeparation);
+    const float yStep = 2.0f / static_cast<float>(layered.LevelCount() + 1);
+    Radius = 0.35f * std::min(xStep, yStep);
+
+    for (int l = 0; l < layered.LevelCount(); ++l) {
+        for (int v : layered.Level(l)) {
+            if (layered.IsDummy(v)) continue;
+            DrawVertex vertex;
+            vertex.index = v;
+            vertex.string = elements[v].ToString();
+            vertex.y = -1.0f + static_cast<float>(l + 1) * yStep;
+            vertex.x = -1.0f + static_cast<float>(x[v] - minX + RealSeparation) * xStep;
+            vertices.push_back(vertex);
+        }
+    }
+    return vertices;
+}
+
+// полный путь раскладки: фиктивные узлы, упорядочивание уровней в пределах options.timeBudget, координаты Брандеса-Кёпфа
+inline std::vector<DrawVertex> LayoutHasse(const ElementList& elements, const HasseGraph& graph,
+                                           const Layering& layering, const LayoutOptions& options = {}) {
+    LayeredGraph layered = LayeredGraph::FromGraph(graph, layering);
+    OrderLayers(layered, options);
+    return VerticesFromHasse(elements, layered);
+}
+
+#endif //AUTOLABA_LAYOUT_H
@@ -0,0 +1,52 @@
+#ifndef AUTOLABA_PARALLEL_H
+#define AUTOLABA_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// число потоков по умолчанию: все доступные ядра
+inline int HardwareThreads() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// параллельный цикл по [begin, end): индексы раздаются кусками по chunk через атомарный счетчик,
+// поэтому неравные по стоимости итерации распределяются равномерно; при threads <= 1 - обычный цикл
+template <class F>
+void ParallelFor(int begin, int end, int threads, F&& body, int chunk = 1) {
+    if (end <= begin) return;
+    threads = std::min(threads, (end - begin + chunk - 1) / chunk);
+    if (threads <= 1) {
+        for (int i = begin; i < end; ++i) body(i);
+        return;
+    }
+
+    std::atomic<int> next(begin);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto worker = [&]() {
+        try {
+            while (true) {
+                const int from = next.fetch_add(chunk);
+                if (from >= end) return;
+                const int to = std::min(end, from + chunk);
+                for (int i = from; i < to; ++i) body(i);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) error = std::current_exception();
+            next.store(end);
+        }
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+    if (error) std::rethrow_exception(error);
+}
+
+#endif //AUTOLABA_PARALLEL_H
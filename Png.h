@@ -0,0 +1,430 @@
+#ifndef AUTOLABA_PNG_H
+#define AUTOLABA_PNG_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Export.h"
+#include "Parallel.h"
+
+/*
+ * Потоковая запись PNG: строки приходят полосами сверху вниз, каждая полоса фильтруется, сжимается
+ * и сразу уходит в файл отдельным IDAT - целиком изображение в памяти не держится.
+ * Сжатие - deflate с фиксированными кодами Хаффмана (как в stb_image_write); полоса заканчивается
+ * пустым stored-блоком, поэтому следующая начинается с границы байта и не ссылается на предыдущую.
+ * Поэтому же полосу можно разрезать на куски и сжимать их параллельно: куски склеиваются как есть,
+ * а контрольные суммы Adler-32 кусков складываются в одну (AdlerCombine).
+ */
+
+namespace PngDetail {
+
+inline const std::array<std::uint32_t, 256>& CrcTable() {
+    static const std::array<std::uint32_t, 256> table = [] {
+        std::array<std::uint32_t, 256> t {};
+        for (std::uint32_t n = 0; n < 256; ++n) {
+            std::uint32_t c = n;
+            for (int k = 0; k < 8; ++k) c = c & 1u ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+    return table;
+}
+
+inline std::uint32_t Crc32(std::uint32_t crc, const unsigned char* data, std::size_t size) {
+    const auto& table = CrcTable();
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; ++i) crc = table[(crc ^ data[i]) & 0xFFu] ^ (crc >> 8);
+    return ~crc;
+}
+
+inline constexpr std::uint32_t AdlerBase = 65521;
+
+inline std::uint32_t Adler32(std::uint32_t adler, const unsigned char* data, std::size_t size) {
+    std::uint32_t a = adler & 0xFFFFu;
+    std::uint32_t b = adler >> 16;
+    while (size > 0) {
+        const std::size_t block = std::min<std::size_t>(size, 5552); // без переполнения до взятия остатка
+        for (std::size_t i = 0; i < block; ++i) {
+            a += data[i];
+            b += a;
+        }
+        a %= AdlerBase;
+        b %= AdlerBase;
+        data += block;
+        size -= block;
+    }
+    return (b << 16) | a;
+}
+
+// Adler-32 склейки двух кусков по их суммам и длине второго (как adler32_combine в zlib)
+inline std::uint32_t AdlerCombine(std::uint32_t first, std::uint32_t second, std::size_t secondSize) {
+    const std::uint64_t rem = secondSize % AdlerBase;
+    const std::uint64_t a1 = first & 0xFFFFu, b1 = first >> 16;
+    const std::uint64_t a2 = second & 0xFFFFu, b2 = second >> 16;
+    const std::uint64_t a = (a1 + a2 + AdlerBase - 1) % AdlerBase;
+    const std::uint64_t b = (rem * a1 + b1 + b2 + AdlerBase - rem) % AdlerBase;
+    return static_cast<std::uint32_t>((b << 16) | a);
+}
+
+// запись битов младшими вперед, как требует deflate
+class BitWriter {
+private:
+    std::vector<unsigned char>& out_;
+    std::uint64_t bits_ = 0;
+    int count_ = 0;
+
+public:
+    explicit BitWriter(std::vector<unsigned char>& out) : out_(out) {}
+
+    void Put(std::uint32_t value, int n) {
+        bits_ |= static_cast<std::uint64_t>(value) << count_;
+        count_ += n;
+        while (count_ >= 8) {
+            out_.push_back(static_cast<unsigned char>(bits_));
+            bits_ >>= 8;
+            count_ -= 8;
+        }
+    }
+    void AlignToByte() {
+        if (count_ > 0) Put(0, 8 - count_);
+    }
+};
+
+// фиксированные коды Хаффмана (RFC 1951, 3.2.6), уже развернутые для записи младшими битами вперед
+struct FixedCodes {
+    std::uint16_t literal[288];
+    std::uint8_t literalBits[288];
+    std::uint8_t distance[30];
+    std::uint16_t lengthSymbol[259];   // длина совпадения 3..258 -> символ 257..285
+    std::uint8_t lengthExtra[259];
+    std::uint16_t lengthBase[259];
+
+    static std::uint32_t Reverse(std::uint32_t code, int bits) {
+        std::uint32_t r = 0;
+        for (int i = 0; i < bits; ++i) r |= ((code >> i) & 1u) << (bits - 1 - i);
+        return r;
+    }
+
+    FixedCodes() {
+        for (int s = 0; s < 288; ++s) {
+            std::uint32_t code;
+            int bits;
+            if (s < 144) code = 0x30 + s, bits = 8;
+            else if (s < 256) code = 0x190 + (s - 144), bits = 9;
+            else if (s < 280) code = s - 256, bits = 7;
+            else code = 0xC0 + (s - 280), bits = 8;
+            literal[s] = static_cast<std::uint16_t>(Reverse(code, bits));
+            literalBits[s] = static_cast<std::uint8_t>(bits);
+        }
+        for (int d = 0; d < 30; ++d) distance[d] = static_cast<std::uint8_t>(Reverse(d, 5));
+        static constexpr int base[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                         35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static constexpr int extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                          3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        for (int code = 0; code < 29; ++code) {
+            const int last = code == 28 ? 258 : base[code] + (1 << extra[code]) - 1;
+            for (int len = base[code]; len <= last && len <= 258; ++len) {
+                lengthSymbol[len] = static_cast<std::uint16_t>(257 + code);
+                lengthExtra[len] = static_cast<std::uint8_t>(extra[code]);
+                lengthBase[len] = static_cast<std::uint16_t>(base[code]);
+            }
+        }
+    }
+};
+
+inline const FixedCodes& Codes() {
+    static const FixedCodes codes;
+    return codes;
+}
+
+inline constexpr int DistanceBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129,
+                                         193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+                                         6145, 8193, 12289, 16385, 24577};
+
+inline int DistanceCode(int d) {
+    int code = 0;
+    while (code < 29 && DistanceBase[code + 1] <= d) ++code;
+    return code;
+}
+
+inline constexpr int WindowSize = 32768;
+inline constexpr int HashBits = 15;
+inline constexpr int MinMatch = 3;
+inline constexpr int MaxMatch = 258;
+
+inline std::uint32_t Hash3(const unsigned char* p) {
+    return ((static_cast<std::uint32_t>(p[0]) << 16 | static_cast<std::uint32_t>(p[1]) << 8 | p[2]) * 2654435761u) >>
+           (32 - HashBits);
+}
+
+} // namespace PngDetail
+
+// сжатие куска независимым deflate-блоком (совпадения ищутся только внутри куска, по цепочкам хешей длиной до chain);
+// last - блок последний в потоке, иначе он закрывается пустым stored-блоком и поток выровнен по байту
+inline void DeflateSegment(const unsigned char* data, std::size_t size, int chain, bool last,
+                           std::vector<unsigned char>& out) {
+    using namespace PngDetail;
+    const FixedCodes& codes = Codes();
+    BitWriter bits(out);
+    bits.Put(last ? 3u : 2u, 3); // BFINAL, BTYPE = 01
+
+    auto literal = [&](int s) { bits.Put(codes.literal[s], codes.literalBits[s]); };
+    std::vector<std::int32_t> head(std::size_t{1} << HashBits, -1);
+    std::vector<std::int32_t> prev(WindowSize, -1);
+    const std::size_t end = size >= MinMatch ? size - MinMatch + 1 : 0; // последние позиции без хеша
+    auto insert = [&](std::size_t pos) {
+        const std::uint32_t h = Hash3(data + pos);
+        prev[pos & (WindowSize - 1)] = head[h];
+        head[h] = static_cast<std::int32_t>(pos);
+    };
+
+    std::size_t pos = 0;
+    while (pos < size) {
+        int bestLength = 0;
+        int bestDistance = 0;
+        if (pos < end && chain > 0) {
+            const std::size_t limit = std::min<std::size_t>(MaxMatch, size - pos);
+            std::int32_t candidate = head[Hash3(data + pos)];
+            for (int steps = 0; candidate >= 0 && steps < chain; ++steps) {
+                const std::size_t distance = pos - static_cast<std::size_t>(candidate);
+                if (distance > WindowSize) break;
+                const unsigned char* a = data + candidate;
+                const unsigned char* b = data + pos;
+                if (a[bestLength] == b[bestLength]) {
+                    std::size_t length = 0;
+                    while (length < limit && a[length] == b[length]) ++length;
+                    if (static_cast<int>(length) > bestLength) {
+                        bestLength = static_cast<int>(length);
+                        bestDistance = static_cast<int>(distance);
+                        if (length == limit) break;
+                    }
+                }
+                candidate = prev[static_cast<std::size_t>(candidate) & (WindowSize - 1)];
+            }
+        }
+        if (bestLength >= MinMatch) {
+            literal(codes.lengthSymbol[bestLength]);
+            if (codes.lengthExtra[bestLength]) bits.Put(bestLength - codes.lengthBase[bestLength], codes.lengthExtra[bestLength]);
+            const int d = DistanceCode(bestDistance);
+            bits.Put(codes.distance[d], 5);
+            const int extra = d < 4 ? 0 : (d - 2) / 2;
+            if (extra) bits.Put(bestDistance - DistanceBase[d], extra);
+            for (std::size_t i = pos; i < pos + bestLength && i < end; ++i) insert(i);
+            pos += bestLength;
+        } else {
+            literal(data[pos]);
+            if (pos < end) insert(pos);
+            ++pos;
+        }
+    }
+    literal(256);
+    if (!last) {
+        bits.Put(0, 3); // пустой stored-блок: выравнивание и LEN = 0, NLEN = 0xFFFF
+        bits.AlignToByte();
+        bits.Put(0x0000, 16);
+        bits.Put(0xFFFF, 16);
+    }
+    bits.AlignToByte();
+}
+
+// фильтр строк PNG: ADAPTIVE выбирает лучший для каждой строки (в пять раз дороже), остальные - один для всех
+enum class PngFilter {
+    ADAPTIVE,
+    NONE,
+    SUB,
+    UP,
+    AVERAGE,
+    PAETH
+};
+
+struct PngOptions {
+    int chain = 32;                         // длина цепочки поиска совпадений: меньше - быстрее и хуже сжатие
+    PngFilter filter = PngFilter::ADAPTIVE;
+    int threads = 1;                        // полоса режется на куски, которые сжимаются параллельно
+
+    // быстрый режим для больших картинок: фильтр Up (диаграммы в основном из одинаковых строк) и короткие цепочки
+    static PngOptions Fast(int threads = 1) { return {4, PngFilter::UP, threads}; }
+};
+
+// PNG 8 бит на канал (3 - RGB, 4 - RGBA), строки сверху вниз; ошибки записи - исключения
+class PngWriter {
+private:
+    // меньше этого кусок не режется: у каждого куска свой словарь, мелкие куски сжимаются хуже
+    static constexpr std::size_t MinPieceBytes = 256 * 1024;
+
+    // кусок полосы: отфильтрованные строки, их сжатие и Adler-32
+    struct Piece {
+        int first = 0;
+        int count = 0;
+        std::vector<unsigned char> filtered;
+        std::vector<unsigned char> compressed;
+        std::uint32_t adler = 1;
+    };
+
+    BufferedWriter out_;
+    int width_;
+    int height_;
+    int channels_;
+    PngOptions options_;
+    int written_ = 0;
+    std::uint32_t adler_ = 1;
+    std::vector<unsigned char> previous_; // последняя строка предыдущей полосы для фильтров Up/Avg/Paeth
+    std::vector<Piece> pieces_;
+
+    void Chunk(const char type[4], const unsigned char* data, std::size_t size) {
+        unsigned char header[8] = {
+            static_cast<unsigned char>(size >> 24), static_cast<unsigned char>(size >> 16),
+            static_cast<unsigned char>(size >> 8), static_cast<unsigned char>(size),
+            static_cast<unsigned char>(type[0]), static_cast<unsigned char>(type[1]),
+            static_cast<unsigned char>(type[2]), static_cast<unsigned char>(type[3])};
+        std::uint32_t crc = PngDetail::Crc32(0, header + 4, 4);
+        crc = PngDetail::Crc32(crc, data, size);
+        const unsigned char tail[4] = {static_cast<unsigned char>(crc >> 24), static_cast<unsigned char>(crc >> 16),
+                                       static_cast<unsigned char>(crc >> 8), static_cast<unsigned char>(crc)};
+        out_.Write(std::string_view(reinterpret_cast<const char*>(header), 8));
+        out_.Write(std::string_view(reinterpret_cast<const char*>(data), size));
+        out_.Write(std::string_view(reinterpret_cast<const char*>(tail), 4));
+    }
+
+    // один фильтр над строкой; возвращает сумму модулей остатков (эвристика выбора из спецификации PNG)
+    long ApplyFilter(PngFilter filter, const unsigned char* row, const unsigned char* up, unsigned char* out) const {
+        const int bytes = width_ * channels_;
+        const int bpp = channels_;
+        long score = 0;
+        for (int i = 0; i < bytes; ++i) {
+            const int a = i >= bpp ? row[i - bpp] : 0;
+            const int b = up ? up[i] : 0;
+            const int c = i >= bpp && up ? up[i - bpp] : 0;
+            int predicted = 0;
+            switch (filter) {
+                case PngFilter::SUB: predicted = a; break;
+                case PngFilter::UP: predicted = b; break;
+                case PngFilter::AVERAGE: predicted = (a + b) / 2; break;
+                case PngFilter::PAETH: {
+                    const int p = a + b - c;
+                    const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+                    predicted = pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+                    break;
+                }
+                default: break;
+            }
+            const auto value = static_cast<unsigned char>(row[i] - predicted);
+            out[i] = value;
+            score += value < 128 ? value : 256 - value;
+        }
+        return score;
+    }
+
+    // строка с байтом типа фильтра в out[0]; up - строка выше или nullptr для первой строки изображения
+    void FilterRow(const unsigned char* row, const unsigned char* up, unsigned char* out,
+                   std::vector<unsigned char>& scratch) const {
+        if (options_.filter != PngFilter::ADAPTIVE) {
+            ApplyFilter(options_.filter, row, up, out + 1);
+            out[0] = static_cast<unsigned char>(static_cast<int>(options_.filter) - 1);
+            return;
+        }
+        scratch.resize(static_cast<std::size_t>(width_) * channels_);
+        long bestScore = -1;
+        for (PngFilter filter : {PngFilter::NONE, PngFilter::SUB, PngFilter::UP, PngFilter::AVERAGE, PngFilter::PAETH}) {
+            const long score = ApplyFilter(filter, row, up, scratch.data());
+            if (bestScore < 0 || score < bestScore) {
+                bestScore = score;
+                out[0] = static_cast<unsigned char>(static_cast<int>(filter) - 1);
+                std::copy(scratch.begin(), scratch.end(), out + 1);
+            }
+        }
+    }
+
+public:
+    PngWriter(const std::string& path, int width, int height, int channels = 3, const PngOptions& options = {})
+        : out_(path), width_(width), height_(height), channels_(channels), options_(options),
+          previous_(static_cast<std::size_t>(width) * channels) {
+        if (width <= 0 || height <= 0 || (channels != 3 && channels != 4)) throw std::runtime_error("Bad PNG size: " + path);
+        static constexpr unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        out_.Write(std::string_view(reinterpret_cast<const char*>(signature), 8));
+        const unsigned char ihdr[13] = {
+            static_cast<unsigned char>(width >> 24), static_cast<unsigned char>(width >> 16),
+            static_cast<unsigned char>(width >> 8), static_cast<unsigned char>(width),
+            static_cast<unsigned char>(height >> 24), static_cast<unsigned char>(height >> 16),
+            static_cast<unsigned char>(height >> 8), static_cast<unsigned char>(height),
+            8, static_cast<unsigned char>(channels == 3 ? 2 : 6), 0, 0, 0};
+        Chunk("IHDR", ihdr, sizeof(ihdr));
+    }
+    PngWriter(const PngWriter&) = delete;
+    PngWriter& operator=(const PngWriter&) = delete;
+
+    int RowsWritten() const { return written_; }
+
+    // count строк подряд, stride - байт между началами строк (отрицательный - строки снизу вверх, как у glReadPixels);
+    // полоса режется на куски по строкам, куски фильтруются и сжимаются параллельно и пишутся по порядку
+    void WriteRows(const unsigned char* rows, int count, std::ptrdiff_t stride) {
+        if (count <= 0) return;
+        if (written_ + count > height_) throw std::runtime_error("Too many PNG rows");
+        const std::size_t rowBytes = static_cast<std::size_t>(width_) * channels_ + 1;
+        const std::size_t byBytes = std::max<std::size_t>(1, rowBytes * count / MinPieceBytes);
+        const int pieces = std::max(1, std::min({options_.threads, count, static_cast<int>(std::min<std::size_t>(byBytes, count))}));
+        if (static_cast<int>(pieces_.size()) < pieces) pieces_.resize(pieces);
+        for (int k = 0; k < pieces; ++k) {
+            pieces_[k].first = static_cast<int>(static_cast<long long>(count) * k / pieces);
+            pieces_[k].count = static_cast<int>(static_cast<long long>(count) * (k + 1) / pieces) - pieces_[k].first;
+        }
+        const bool first = written_ == 0;
+        ParallelFor(0, pieces, options_.threads, [&](int k) {
+            Piece& piece = pieces_[k];
+            std::vector<unsigned char> scratch;
+            piece.filtered.resize(rowBytes * piece.count);
+            for (int y = 0; y < piece.count; ++y) {
+                const int index = piece.first + y;
+                const unsigned char* row = rows + stride * index;
+                const unsigned char* up = index > 0 ? rows + stride * (index - 1) : first ? nullptr : previous_.data();
+                FilterRow(row, up, piece.filtered.data() + rowBytes * y, scratch);
+            }
+            piece.adler = PngDetail::Adler32(1, piece.filtered.data(), piece.filtered.size());
+            piece.compressed.clear();
+            DeflateSegment(piece.filtered.data(), piece.filtered.size(), options_.chain, false, piece.compressed);
+        });
+
+        const unsigned char* last = rows + stride * (count - 1);
+        std::copy(last, last + previous_.size(), previous_.begin());
+        written_ += count;
+        if (first) {
+            static constexpr unsigned char zlibHeader[2] = {0x78, 0x01};
+            Chunk("IDAT", zlibHeader, 2);
+        }
+        for (int k = 0; k < pieces; ++k) {
+            const Piece& piece = pieces_[k];
+            adler_ = PngDetail::AdlerCombine(adler_, piece.adler, piece.filtered.size());
+            Chunk("IDAT", piece.compressed.data(), piece.compressed.size());
+        }
+    }
+
+    // последний пустой блок, контрольная сумма zlib и IEND
+    void Close() {
+        if (written_ != height_) throw std::runtime_error("PNG is incomplete: " + std::to_string(written_) + " of " +
+                                                          std::to_string(height_) + " rows");
+        std::vector<unsigned char> tail;
+        DeflateSegment(nullptr, 0, 0, true, tail);
+        for (int shift = 24; shift >= 0; shift -= 8) tail.push_back(static_cast<unsigned char>(adler_ >> shift));
+        Chunk("IDAT", tail.data(), tail.size());
+        Chunk("IEND", nullptr, 0);
+        out_.Close();
+    }
+};
+
+// изображение целиком одним вызовом; stride < 0 - строки в памяти снизу вверх
+inline void WritePng(const std::string& path, const unsigned char* rows, int width, int height, int channels,
+                     std::ptrdiff_t stride, const PngOptions& options = {}) {
+    PngWriter png(path, width, height, channels, options);
+    png.WriteRows(rows, height, stride);
+    png.Close();
+}
+
+#endif //AUTOLABA_PNG_H
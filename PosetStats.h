@@ -0,0 +1,47 @@
+#ifndef AUTOLABA_POSETSTATS_H
+#define AUTOLABA_POSETSTATS_H
+
+#include <bit>
+#include <vector>
+
+#include "Graph.h"
+#include "Layering.h"
+
+// экстремальные характеристики частично упорядоченного множества, считаются за O(n + E) по CSR
+struct PosetStats {
+    std::vector<int> minimal;        // входящая степень 0
+    std::vector<int> maximal;        // исходящая степень 0 (в том числе на нижних уровнях)
+    int height = 0;                  // число элементов в самой длинной цепи
+    int width = 0;                   // размер самого широкого уровня
+    std::vector<int> levelHistogram; // число элементов на каждом уровне
+    long long comparablePairs = -1;  // число сравнимых пар, -1 если замыкание не посчитано
+};
+
+inline PosetStats ComputePosetStats(const HasseGraph& g, const Layering& layering, const Reachability* reach = nullptr) {
+    PosetStats stats;
+    for (int v = 0; v < g.n; ++v) {
+        if (g.InDegree(v) == 0) stats.minimal.push_back(v);
+        if (g.OutDegree(v) == 0) stats.maximal.push_back(v);
+    }
+
+    stats.height = layering.LevelCount();
+    stats.levelHistogram.resize(stats.height);
+    for (int l = 0; l < stats.height; ++l) stats.levelHistogram[l] = layering.LevelSize(l);
+    stats.width = layering.MaxLevelSize();
+
+    if (reach) {
+        // строка замыкания содержит саму вершину, остальные биты - строго большие элементы;
+        // вершины на циклах (ребра, заданные парами) строк не получают и пропускаются
+        long long pairs = 0;
+        for (int u = 0; u < reach->n; ++u) {
+            if (!reach->Reaches(u, u)) continue;
+            const std::uint64_t* row = reach->Row(u);
+            for (int k = 0; k < reach->words; ++k) pairs += std::popcount(row[k]);
+            --pairs;
+        }
+        stats.comparablePairs = pairs;
+    }
+    return stats;
+}
+
+#endif //AUTOLABA_POSETSTATS_H
@@ -0,0 +1,251 @@
+#ifndef AUTOLABA_POSTER_H
+#define AUTOLABA_POSTER_H
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Parallel.h"
+#include "Png.h"
+#include "Raster.h"
+#include "SpatialIndex.h"
+
+/*
+ * Постер - изображение любого размера (20000x20000 и больше), которое не помещается ни в окно, ни в память целиком.
+ * Картинка режется на плитки, плитки одной полосы рисуются параллельно программным растеризатором
+ * (каждая берет из сетки только свои вершины и ребра), готовая полоса сразу уходит в PngWriter.
+ * В памяти одновременно только одна полоса высотой в плитку.
+ */
+
+struct PosterOptions {
+    int width = 16384;
+    int height = 16384;
+    int tileSize = 1024;   // сторона плитки отрисовки
+    int threads = 1;
+    bool pyramid = false;  // дополнительно пирамида Deep Zoom (name.dzi, name_files/, name.html)
+    int pyramidTile = 256; // сторона плитки пирамиды
+    PngOptions png;
+    RasterStyle style;
+};
+
+// пирамида Deep Zoom: уровень max - исходное изображение, каждый следующий вниз вдвое меньше, уровень 0 - 1x1.
+// Строки приходят сверху вниз; уровень копит строки на одну полосу плиток и сбрасывает их в файлы,
+// а каждая пара строк усредняется в строку уровня ниже - так вся пирамида строится за один проход
+class DeepZoomWriter {
+private:
+    struct Level {
+        int width = 0;
+        int height = 0;
+        int rows = 0;                          // строк уровня уже получено
+        std::vector<unsigned char> band;       // строки текущей полосы плиток
+        std::vector<unsigned char> pending;    // четная строка, ждущая пары для уровня ниже
+        bool hasPending = false;
+        std::filesystem::path dir;
+    };
+
+    std::vector<Level> levels_;
+    int tile_;
+    int threads_;
+    PngOptions png_; // плитки маленькие - каждая сжимается в один поток, параллельно идут плитки
+
+    void Flush(Level& level) {
+        const int first = (level.rows - 1) / tile_ * tile_;
+        const int bandRows = level.rows - first;
+        const int columns = (level.width + tile_ - 1) / tile_;
+        const int tileRow = first / tile_;
+        ParallelFor(0, columns, threads_, [&](int column) {
+            const int x0 = column * tile_;
+            const int w = std::min(tile_, level.width - x0);
+            const std::string path =
+                (level.dir / (std::to_string(column) + "_" + std::to_string(tileRow) + ".png")).string();
+            const unsigned char* start = level.band.data() + static_cast<std::size_t>(x0) * 3;
+            WritePng(path, start, w, bandRows, 3, static_cast<std::ptrdiff_t>(level.width) * 3, png_);
+        });
+    }
+
+    // строка уровня index; четные строки ждут пары, нечетные вместе с ними дают строку уровня ниже
+    void Push(int index, const unsigned char* row) {
+        Level& level = levels_[index];
+        const std::size_t bytes = static_cast<std::size_t>(level.width) * 3;
+        std::copy(row, row + bytes, level.band.begin() + static_cast<std::ptrdiff_t>((level.rows % tile_) * bytes));
+        ++level.rows;
+        if (level.rows % tile_ == 0 || level.rows == level.height) Flush(level);
+        if (index == 0) return;
+
+        const bool last = level.rows == level.height;
+        if (!level.hasPending && !last) {
+            level.pending.assign(row, row + bytes);
+            level.hasPending = true;
+            return;
+        }
+        const unsigned char* top = level.hasPending ? level.pending.data() : row;
+        level.hasPending = false;
+        const int lowerWidth = levels_[index - 1].width;
+        std::vector<unsigned char> lower(static_cast<std::size_t>(lowerWidth) * 3);
+        for (int x = 0; x < lowerWidth; ++x) {
+            const std::size_t a = static_cast<std::size_t>(2 * x) * 3;
+            const std::size_t b = static_cast<std::size_t>(std::min(2 * x + 1, level.width - 1)) * 3;
+            for (int c = 0; c < 3; ++c) {
+                lower[x * 3 + c] = static_cast<unsigned char>((top[a + c] + top[b + c] + row[a + c] + row[b + c] + 2) / 4);
+            }
+        }
+        Push(index - 1, lower.data());
+    }
+
+public:
+    // dir/name.dzi и плитки в dir/name_files/<уровень>/<столбец>_<строка>.png
+    DeepZoomWriter(const std::filesystem::path& dir, const std::string& name, int width, int height, int tile = 256,
+                   int threads = 1, const PngOptions& png = {})
+        : tile_(tile), threads_(threads), png_(png) {
+        png_.threads = 1;
+        if (width <= 0 || height <= 0 || tile <= 0) throw std::runtime_error("Bad pyramid size");
+        int maxLevel = 0;
+        while ((1 << maxLevel) < std::max(width, height)) ++maxLevel;
+        levels_.resize(maxLevel + 1);
+        for (int k = maxLevel; k >= 0; --k) {
+            Level& level = levels_[k];
+            const int shift = maxLevel - k;
+            level.width = ((width - 1) >> shift) + 1;
+            level.height = ((height - 1) >> shift) + 1;
+            level.band.resize(static_cast<std::size_t>(level.width) * 3 * std::min(tile, level.height));
+            level.dir = dir / (name + "_files") / std::to_string(k);
+            std::filesystem::create_directories(level.dir);
+        }
+
+        const std::string dzi = (dir / (name + ".dzi")).string();
+        std::ofstream out(dzi);
+        if (!out) throw std::runtime_error("Cannot write " + dzi);
+        out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            << "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\" Format=\"png\" Overlap=\"0\" TileSize=\""
+            << tile << "\">\n  <Size Width=\"" << width << "\" Height=\"" << height << "\"/>\n</Image>\n";
+    }
+
+    int MaxLevel() const { return static_cast<int>(levels_.size()) - 1; }
+
+    // count строк исходного изображения подряд, stride - байт между началами строк
+    void WriteRows(const unsigned char* rows, int count, std::ptrdiff_t stride) {
+        for (int y = 0; y < count; ++y) Push(MaxLevel(), rows + stride * y);
+    }
+
+    void Close() const {
+        for (const Level& level : levels_) {
+            if (level.rows != level.height) throw std::runtime_error("Pyramid is incomplete");
+        }
+    }
+};
+
+// страница просмотра пирамиды без сторонних библиотек: колесо - масштаб у курсора, перетаскивание - сдвиг
+inline void WriteDeepZoomViewer(const std::filesystem::path& path, const std::string& name, int width, int height,
+                                int tile, int maxLevel) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("Cannot write " + path.string());
+    out << "<!DOCTYPE html>\n<html><head><meta charset=\"utf-8\"><title>" << name << "</title>\n"
+        << "<style>html,body{margin:0;height:100%;overflow:hidden;background:#fff}canvas{display:block}</style>\n"
+        << "</head><body><canvas id=\"c\"></canvas><script>\n"
+        << "const W=" << width << ",H=" << height << ",T=" << tile << ",MAX=" << maxLevel
+        << ",DIR=\"" << name << "_files\";\n"
+        << R"(const c=document.getElementById("c"),g=c.getContext("2d"),cache=new Map();
+let scale=1,ox=0,oy=0,drag=null;
+function fit(){c.width=innerWidth;c.height=innerHeight;scale=Math.min(c.width/W,c.height/H);
+  ox=(c.width-W*scale)/2;oy=(c.height-H*scale)/2;}
+function tile(l,x,y){const k=l+"/"+x+"_"+y;let t=cache.get(k);
+  if(!t){t=new Image();t.onload=draw;t.src=DIR+"/"+k+".png";cache.set(k,t);}return t;}
+function draw(){g.fillStyle="#fff";g.fillRect(0,0,c.width,c.height);
+  const l=Math.min(MAX,Math.max(0,MAX+Math.ceil(Math.log2(scale)))),f=Math.pow(2,MAX-l),s=scale*f;
+  const cols=Math.ceil(Math.ceil(W/f)/T),rows=Math.ceil(Math.ceil(H/f)/T);
+  const x0=Math.max(0,Math.floor(-ox/s/T)),y0=Math.max(0,Math.floor(-oy/s/T));
+  const x1=Math.min(cols-1,Math.floor((c.width-ox)/s/T)),y1=Math.min(rows-1,Math.floor((c.height-oy)/s/T));
+  for(let y=y0;y<=y1;y++)for(let x=x0;x<=x1;x++){const t=tile(l,x,y);
+    if(t.complete&&t.naturalWidth)g.drawImage(t,ox+x*T*s,oy+y*T*s,t.naturalWidth*s,t.naturalHeight*s);}}
+c.onwheel=e=>{e.preventDefault();const k=Math.pow(1.2,-Math.sign(e.deltaY));
+  ox=e.clientX-(e.clientX-ox)*k;oy=e.clientY-(e.clientY-oy)*k;scale*=k;draw();};
+c.onmousedown=e=>{drag=[e.clientX,e.clientY];};
+onmouseup=()=>{drag=null;};
+onmousemove=e=>{if(!drag)return;ox+=e.clientX-drag[0];oy+=e.clientY-drag[1];drag=[e.clientX,e.clientY];draw();};
+onresize=()=>{fit();draw();};
+fit();draw();
+</script></body></html>
+)";
+}
+
+// постер в path (PNG); при options.pyramid рядом - name.dzi, name_files/ и name.html, где name - имя path без расширения
+inline void RenderPoster(const std::string& path, const std::vector<DrawVertex>& vertices,
+                         const std::vector<HasseBuilder::Edge>& edges, float radius, const PosterOptions& options = {}) {
+    const int width = options.width, height = options.height, tileSize = options.tileSize;
+    if (width <= 0 || height <= 0 || tileSize <= 0) throw std::runtime_error("Bad poster size");
+    const std::vector<EdgeSegment> segments = EdgeGeometry(vertices, edges);
+    SpatialGrid grid;
+    grid.Build(vertices, segments);
+
+    // запас вокруг плитки в координатах раскладки: круг, сглаживание и подпись соседней вершины
+    const RasterViewport full {width, height, 0, 0};
+    const float sx = 0.5f * static_cast<float>(width);
+    const float sy = 0.5f * static_cast<float>(height);
+    int labelWidth = 0;
+    if (radius * sx >= options.style.minLabelRadius) {
+        for (const DrawVertex& v : vertices) labelWidth = std::max(labelWidth, FontTextWidth(v.string));
+    }
+    const int textScale = RasterTextScale(full);
+    const float marginX = radius + (static_cast<float>(labelWidth * textScale) / 2.0f + 2.0f) / sx;
+    const float marginY = radius + 0.05f + (static_cast<float>(FontGlyphHeight * textScale) + 2.0f) / sy;
+
+    PngWriter png(path, width, height, 3, options.png);
+    std::optional<DeepZoomWriter> pyramid;
+    const std::filesystem::path target(path);
+    if (options.pyramid) {
+        pyramid.emplace(target.parent_path(), target.stem().string(), width, height, options.pyramidTile, options.threads,
+                        options.png);
+    }
+
+    const int columns = (width + tileSize - 1) / tileSize;
+    std::vector<unsigned char> band(static_cast<std::size_t>(width) * 3 * std::min(tileSize, height));
+    // у каждой плитки свои ответы сетки и отметки: плитки полосы рисуются параллельно
+    struct TileScratch {
+        std::vector<int> vertices;
+        std::vector<int> segments;
+        std::vector<unsigned> stamp;
+        unsigned epoch = 0;
+    };
+    std::vector<TileScratch> scratch(columns);
+
+    for (int originY = 0; originY < height; originY += tileSize) {
+        const int rows = std::min(tileSize, height - originY);
+        ParallelFor(0, columns, options.threads, [&](int column) {
+            const int originX = column * tileSize;
+            const int columnsHere = std::min(tileSize, width - originX);
+            TileScratch& s = scratch[column];
+            WorldRect rect;
+            rect.x0 = static_cast<float>(originX) / sx - 1.0f - marginX;
+            rect.x1 = static_cast<float>(originX + columnsHere) / sx - 1.0f + marginX;
+            rect.y0 = 1.0f - static_cast<float>(originY + rows) / sy - marginY;
+            rect.y1 = 1.0f - static_cast<float>(originY) / sy + marginY;
+            grid.Query(rect, s.vertices, s.segments, s.stamp, s.epoch);
+            // исходный порядок: сглаженные края смешиваются так же, как при отрисовке целиком
+            std::sort(s.vertices.begin(), s.vertices.end());
+            std::sort(s.segments.begin(), s.segments.end());
+
+            Canvas canvas(columnsHere, rows, options.style.background);
+            RasterizeHasse(canvas, RasterViewport {width, height, originX, originY}, vertices, segments, radius,
+                           options.style, &s.vertices, &s.segments);
+            for (int y = 0; y < rows; ++y) {
+                std::copy(canvas.Row(y), canvas.Row(y) + static_cast<std::size_t>(columnsHere) * 3,
+                          band.begin() + static_cast<std::ptrdiff_t>((static_cast<std::size_t>(y) * width + originX) * 3));
+            }
+        });
+        png.WriteRows(band.data(), rows, static_cast<std::ptrdiff_t>(width) * 3);
+        if (pyramid) pyramid->WriteRows(band.data(), rows, static_cast<std::ptrdiff_t>(width) * 3);
+    }
+    png.Close();
+    if (pyramid) {
+        pyramid->Close();
+        WriteDeepZoomViewer(target.parent_path() / (target.stem().string() + ".html"), target.stem().string(), width,
+                            height, options.pyramidTile, pyramid->MaxLevel());
+    }
+}
+
+#endif //AUTOLABA_POSTER_H
@@ -0,0 +1,248 @@
+#ifndef AUTOLABA_RASTER_H
+#define AUTOLABA_RASTER_H
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "BitmapFont.h"
+#include "HasseBuilder.h"
+#include "Layout.h"
+#include "Png.h"
+
+// программная отрисовка диаграммы в память без GL/GLFW/GLUT (для серверов без экрана)
+
+struct RasterColor {
+    unsigned char r = 0;
+    unsigned char g = 0;
+    unsigned char b = 0;
+};
+
+// RGB-буфер с построчной раскладкой сверху вниз (как ждет PngWriter)
+class Canvas {
+private:
+    int width_ = 0;
+    int height_ = 0;
+    std::vector<unsigned char> pixels_;
+
+public:
+    Canvas(int width, int height, RasterColor background = {255, 255, 255})
+        : width_(width), height_(height), pixels_(static_cast<std::size_t>(width) * height * 3) {
+        Clear(background);
+    }
+
+    int Width() const { return width_; }
+    int Height() const { return height_; }
+    const unsigned char* Data() const { return pixels_.data(); }
+    const unsigned char* Row(int y) const { return pixels_.data() + static_cast<std::size_t>(y) * width_ * 3; }
+
+    void Clear(RasterColor c) {
+        for (std::size_t i = 0; i < pixels_.size(); i += 3) {
+            pixels_[i] = c.r;
+            pixels_[i + 1] = c.g;
+            pixels_[i + 2] = c.b;
+        }
+    }
+
+    // смешивание цвета с покрытием alpha в [0, 1] (внутри - целочисленное, 0..256)
+    void Blend(int x, int y, RasterColor c, float alpha) {
+        BlendFixed(x, y, c, static_cast<int>(alpha * 256.0f + 0.5f));
+    }
+    void BlendFixed(int x, int y, RasterColor c, int a) {
+        if (static_cast<unsigned>(x) >= static_cast<unsigned>(width_) ||
+            static_cast<unsigned>(y) >= static_cast<unsigned>(height_) || a <= 0) return;
+        unsigned char* p = pixels_.data() + (static_cast<std::size_t>(y) * width_ + x) * 3;
+        if (a >= 256) {
+            p[0] = c.r;
+            p[1] = c.g;
+            p[2] = c.b;
+            return;
+        }
+        p[0] = static_cast<unsigned char>(p[0] + (((c.r - p[0]) * a) >> 8));
+        p[1] = static_cast<unsigned char>(p[1] + (((c.g - p[1]) * a) >> 8));
+        p[2] = static_cast<unsigned char>(p[2] + (((c.b - p[2]) * a) >> 8));
+    }
+
+    // сглаженная линия (алгоритм Ву), предварительно обрезанная по границам холста
+    void DrawLine(float x0, float y0, float x1, float y1, RasterColor c) {
+        if (!ClipLine(x0, y0, x1, y1)) return;
+        const bool steep = std::abs(y1 - y0) > std::abs(x1 - x0);
+        if (steep) {
+            std::swap(x0, y0);
+            std::swap(x1, y1);
+        }
+        if (x0 > x1) {
+            std::swap(x0, x1);
+            std::swap(y0, y1);
+        }
+        const float dx = x1 - x0;
+        const float gradient = dx < 1e-6f ? 1.0f : (y1 - y0) / dx;
+        // y ведется в фиксированной точке 16.16: дробная часть дает покрытие двух соседних пикселей
+        const int xStart = static_cast<int>(std::lround(x0));
+        const int xEnd = static_cast<int>(std::lround(x1));
+        long long y = std::llround((y0 + gradient * (static_cast<float>(xStart) - x0)) * 65536.0f);
+        const long long step = std::llround(gradient * 65536.0f);
+        for (int x = xStart; x <= xEnd; ++x) {
+            const int base = static_cast<int>(y >> 16);
+            const int frac = static_cast<int>((y >> 8) & 0xFF);
+            if (steep) {
+                BlendFixed(base, x, c, 256 - frac);
+                BlendFixed(base + 1, x, c, frac);
+            } else {
+                BlendFixed(x, base, c, 256 - frac);
+                BlendFixed(x, base + 1, c, frac);
+            }
+            y += step;
+        }
+    }
+
+    // круг со сглаженным краем: внутренняя часть строки заливается сплошным отрезком
+    void FillCircle(float cx, float cy, float r, RasterColor c) {
+        const int yMin = std::max(0, static_cast<int>(std::floor(cy - r - 1.0f)));
+        const int yMax = std::min(height_ - 1, static_cast<int>(std::ceil(cy + r + 1.0f)));
+        const float outer = r + 0.5f;
+        const float inner = std::max(0.0f, r - 0.5f);
+        for (int y = yMin; y <= yMax; ++y) {
+            const float dy = static_cast<float>(y) + 0.5f - cy;
+            if (std::abs(dy) >= outer) continue;
+            const float outerHalf = std::sqrt(outer * outer - dy * dy);
+            const float innerHalf = std::abs(dy) < inner ? std::sqrt(inner * inner - dy * dy) : 0.0f;
+            const int xMin = std::max(0, static_cast<int>(std::floor(cx - outerHalf)));
+            const int xMax = std::min(width_ - 1, static_cast<int>(std::ceil(cx + outerHalf)));
+            const int solidMin = static_cast<int>(std::ceil(cx - innerHalf));
+            const int solidMax = static_cast<int>(std::floor(cx + innerHalf)) - 1;
+            for (int x = xMin; x <= xMax; ++x) {
+                if (x >= solidMin && x <= solidMax) {
+                    Blend(x, y, c, 1.0f);
+                    continue;
+                }
+                const float ddx = static_cast<float>(x) + 0.5f - cx;
+                const float d = std::sqrt(ddx * ddx + dy * dy);
+                Blend(x, y, c, std::clamp(r - d + 0.5f, 0.0f, 1.0f));
+            }
+        }
+    }
+
+    // текст встроенным шрифтом; (x, y) - левый верхний угол, scale - размер пикселя шрифта
+    void DrawText(int x, int y, std::string_view text, RasterColor c, int scale) {
+        if (y >= height_ || y + FontCellHeight * scale <= 0) return;
+        for (char ch : text) {
+            if (x >= width_) return;
+            if (x + FontCellWidth * scale > 0) {
+                for (int gy = 0; gy < FontGlyphHeight; ++gy) {
+                    for (int gx = 0; gx < FontGlyphWidth; ++gx) {
+                        if (!FontPixel(ch, gx, gy)) continue;
+                        for (int sy = 0; sy < scale; ++sy)
+                            for (int sx = 0; sx < scale; ++sx)
+                                Blend(x + gx * scale + sx, y + gy * scale + sy, c, 1.0f);
+                    }
+                }
+            }
+            x += FontCellWidth * scale;
+        }
+    }
+
+    // ошибки записи (путь, место на диске) приходят исключением с причиной
+    void SavePng(const std::string& path, const PngOptions& options = {}) const {
+        WritePng(path, pixels_.data(), width_, height_, 3, static_cast<std::ptrdiff_t>(width_) * 3, options);
+    }
+
+private:
+    // обрезка Лианга-Барски по прямоугольнику холста с запасом в пиксель под сглаживание
+    bool ClipLine(float& x0, float& y0, float& x1, float& y1) const {
+        const float xmin = -1.0f, ymin = -1.0f;
+        const float xmax = static_cast<float>(width_), ymax = static_cast<float>(height_);
+        const float dx = x1 - x0, dy = y1 - y0;
+        float t0 = 0.0f, t1 = 1.0f;
+        const float p[4] = {-dx, dx, -dy, dy};
+        const float q[4] = {x0 - xmin, xmax - x0, y0 - ymin, ymax - y0};
+        for (int i = 0; i < 4; ++i) {
+            if (p[i] == 0.0f) {
+                if (q[i] < 0.0f) return false;
+                continue;
+            }
+            const float t = q[i] / p[i];
+            if (p[i] < 0.0f) t0 = std::max(t0, t);
+            else t1 = std::min(t1, t);
+            if (t0 > t1) return false;
+        }
+        const float nx0 = x0 + t0 * dx, ny0 = y0 + t0 * dy;
+        x1 = x0 + t1 * dx;
+        y1 = y0 + t1 * dy;
+        x0 = nx0;
+        y0 = ny0;
+        return true;
+    }
+};
+
+// какая часть полного изображения лежит в холсте (для плиток большого постера)
+struct RasterViewport {
+    int fullWidth = 600;
+    int fullHeight = 600;
+    int originX = 0;
+    int originY = 0;
+};
+
+// размер шрифта растет вместе с изображением: на 600x600 пиксель шрифта равен 2 пикселям
+inline int RasterTextScale(const RasterViewport& view) {
+    return std::max(1, view.fullHeight / 300);
+}
+
+struct RasterStyle {
+    RasterColor background {255, 255, 255};
+    RasterColor edge {0, 0, 0};
+    RasterColor vertex {255, 192, 203};
+    RasterColor text {0, 0, 0};
+    float minLabelRadius = MinLabelRadius; // подписи у вершин меньше этого радиуса (в пикселях) не рисуются
+};
+
+// отрисовка ребер, вершин и подписей так же, как это делает DrawHasse, но в память;
+// vertexSubset/segmentSubset (позиции в vertices/segments) ограничивают работу тем, что попадает в холст, nullptr - все
+inline void RasterizeHasse(Canvas& canvas, const RasterViewport& view, const std::vector<DrawVertex>& vertices,
+                           const std::vector<EdgeSegment>& segments, float radius, const RasterStyle& style = {},
+                           const std::vector<int>* vertexSubset = nullptr, const std::vector<int>* segmentSubset = nullptr) {
+    const float sx = 0.5f * static_cast<float>(view.fullWidth);
+    const float sy = 0.5f * static_cast<float>(view.fullHeight);
+    auto px = [&](float x) { return (x + 1.0f) * sx - static_cast<float>(view.originX); };
+    auto py = [&](float y) { return (1.0f - y) * sy - static_cast<float>(view.originY); };
+    auto forVertices = [&](auto&& body) {
+        if (vertexSubset) for (int v : *vertexSubset) body(vertices[v]);
+        else for (const DrawVertex& v : vertices) body(v);
+    };
+
+    auto line = [&](const EdgeSegment& e) { canvas.DrawLine(px(e.x0), py(e.y0), px(e.x1), py(e.y1), style.edge); };
+    if (segmentSubset) for (int s : *segmentSubset) line(segments[s]);
+    else for (const EdgeSegment& e : segments) line(e);
+
+    const float r = radius * sx;
+    forVertices([&](const DrawVertex& v) { canvas.FillCircle(px(v.x), py(v.y), r, style.vertex); });
+
+    if (r < style.minLabelRadius) return;
+    const int scale = RasterTextScale(view);
+    forVertices([&](const DrawVertex& v) {
+        const int w = FontTextWidth(v.string) * scale;
+        // floor, а не усечение: у плитки постера координаты бывают отрицательными, и подпись не должна сдвигаться
+        const float baseline = std::floor(py(v.y - (radius + 0.05f)));
+        canvas.DrawText(static_cast<int>(std::floor(px(v.x))) - w / 2, static_cast<int>(baseline) - FontGlyphHeight * scale,
+                        v.string, style.text, scale);
+    });
+}
+inline void RasterizeHasse(Canvas& canvas, const RasterViewport& view, const std::vector<DrawVertex>& vertices,
+                           const std::vector<HasseBuilder::Edge>& edges, float radius, const RasterStyle& style = {}) {
+    RasterizeHasse(canvas, view, vertices, EdgeGeometry(vertices, edges), radius, style);
+}
+
+// однократная отрисовка в PNG; при ошибке записи - исключение
+inline void RenderHassePng(const std::string& path, const std::vector<DrawVertex>& vertices,
+                           const std::vector<HasseBuilder::Edge>& edges, float radius, int width = 600, int height = 600,
+                           const PngOptions& png = {}) {
+    const RasterStyle style;
+    Canvas canvas(width, height, style.background);
+    RasterizeHasse(canvas, RasterViewport {width, height, 0, 0}, vertices, edges, radius, style);
+    canvas.SavePng(path, png);
+}
+
+#endif //AUTOLABA_RASTER_H
@@ -1,7 +1,10 @@
 #ifndef AUTOLABA_RULES_H
 #define AUTOLABA_RULES_H
 
+#include <algorithm>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <stdexcept>
 
@@ -20,39 +23,53 @@ public:
 
     Element::Type GetMode() const {return mode;}
 
-    Cmp Compare(const Element& a, const Element& b) const {
+    // проверка, что правило выбрано и подходит для элементов данного типа
+    void Require(Element::Type type) const {
         if (!rule_selected_) {
             throw std::runtime_error("Rules: no rule selected (choose a rule explicitly)");
         }
-        if (a.GetType() != mode || b.GetType() != mode) {
+        if (type != mode) {
             throw std::runtime_error("Rules: element type does not match mode");
         }
+    }
 
-        switch (mode) {
-            case Element::Type::STRING:
-                if (string_rule_ == StringRule::PREFIX) {
-                    return CompareStringsPrefix(a.AsString(), b.AsString());
-                } else if (string_rule_ == StringRule::LEX) {
-                    return CompareStringsLex(a.AsString(), b.AsString());
-                } else {
-                    return CompareStringsSubSeq(a.AsString(), b.AsString());
-                }
-
-            case Element::Type::INT:
-                return (int_rule_ == IntRule::DIVIDES)
-                    ? CompareIntsDivides(a.AsInt(), b.AsInt())
-                    : CompareIntsLeq(a.AsInt(), b.AsInt());
-
-            case Element::Type::SET_INT:
-                return (set_rule_ == SetRule::SUBSET)
-                    ? CompareSetsSubset(a.AsSetInt(), b.AsSetInt())
-                    : CompareSetsSize(a.AsSetInt(), b.AsSetInt());
+    Cmp Compare(const Element& a, const Element& b) const {
+        Require(a.GetType());
+        Require(b.GetType());
 
+        switch (mode) {
+            case Element::Type::STRING: return CompareStrings(a.AsString(), b.AsString());
+            case Element::Type::INT:    return CompareInts(a.AsInt(), b.AsInt());
+            case Element::Type::SET_INT: return CompareSets(a.AsSetInt(), b.AsSetInt());
             case Element::Type::NONE: return Cmp::Incomparable;
         }
         return Cmp::Incomparable;
     }
 
+    // сравнение "сырых" значений без обертки Element (используется при загрузке из бинарного файла),
+    // проверку правила вызывающий делает один раз через Require
+    Cmp CompareStrings(std::string_view x, std::string_view y) const {
+        if (string_rule_ == StringRule::PREFIX) {
+            return CompareStringsPrefix(x, y);
+        } else if (string_rule_ == StringRule::LEX) {
+            return CompareStringsLex(x, y);
+        } else {
+            return CompareStringsSubSeq(x, y);
+        }
+    }
+
+    Cmp CompareInts(int a, int b) const {
+        return (int_rule_ == IntRule::DIVIDES)
+            ? CompareIntsDivides(a, b)
+            : CompareIntsLeq(a, b);
+    }
+
+    Cmp CompareSets(std::span<const int> A, std::span<const int> B) const {
+        return (set_rule_ == SetRule::SUBSET)
+            ? CompareSetsSubset(A, B)
+            : CompareSetsSize(A, B);
+    }
+
     static Rules ForString(StringRule r) {
         Rules rules(Element::Type::STRING);
         rules.string_rule_ = r;
@@ -81,26 +98,26 @@ private:
     SetRule set_rule_ = SetRule::SUBSET;
     bool rule_selected_ = false;
 
-    static Cmp CompareStringsPrefix(const std::string& x, const std::string& y) {
+    static Cmp CompareStringsPrefix(std::string_view x, std::string_view y) {
         if (x == y) return Cmp::Equal;
         if (IsPrefix(x, y)) return Cmp::Less;
         if (IsPrefix(y, x)) return Cmp::Greater;
         return Cmp::Incomparable;
     }
 
-    static Cmp CompareStringsLex(const std::string& x, const std::string& y) {
+    static Cmp CompareStringsLex(std::string_view x, std::string_view y) {
         if (x == y) return Cmp::Equal;
         return (x < y) ? Cmp::Less : Cmp::Greater;
     }
 
-    static Cmp CompareStringsSubSeq(const std::string& x, const std::string& y) {
+    static Cmp CompareStringsSubSeq(std::string_view x, std::string_view y) {
         if (x == y) return Cmp::Equal;
         if (IsPart(x, y)) return Cmp::Less;
         if (IsPart(y, x)) return Cmp::Greater;
         return Cmp::Incomparable;
     }
 
-    static bool IsPart(const std::string& seq1, const std::string& seq2) {
+    static bool IsPart(std::string_view seq1, std::string_view seq2) {
         int index1 = 0;
         int index2 = 0;
         while (index1 < seq1.size() && index2 < seq2.size()) {
@@ -117,9 +134,9 @@ private:
         return false;
     }
 
-    static bool IsPrefix(const std::string& pref, const std::string& s) {
+    static bool IsPrefix(std::string_view pref, std::string_view s) {
         if (pref.size() > s.size()) return false;
-        return s.rfind(pref, 0) == 0;
+        return s.substr(0, pref.size()) == pref;
     }
 
     static Cmp CompareIntsDivides(int a, int b) {
@@ -141,8 +158,8 @@ private:
         return (b % a) == 0;
     }
 
-    static Cmp CompareSetsSubset(const std::vector<int>& A, const std::vector<int>& B) {
-        if (A == B) return Cmp::Equal;
+    static Cmp CompareSetsSubset(std::span<const int> A, std::span<const int> B) {
+        if (std::ranges::equal(A, B)) return Cmp::Equal;
         const bool A_in_B = IsSubset(A, B);
         const bool B_in_A = IsSubset(B, A);
         if (A_in_B) return Cmp::Less;
@@ -150,14 +167,14 @@ private:
         return Cmp::Incomparable;
     }
 
-    static Cmp CompareSetsSize(const std::vector<int>& A, const std::vector<int>& B) {
-        if (A == B) return Cmp::Equal;
+    static Cmp CompareSetsSize(std::span<const int> A, std::span<const int> B) {
+        if (std::ranges::equal(A, B)) return Cmp::Equal;
         if (A.size() < B.size()) return Cmp::Less;
         if (A.size() > B.size()) return Cmp::Greater;
         return Cmp::Incomparable;
     }
 
-    static bool IsSubset(const std::vector<int>& A, const std::vector<int>& B) {
+    static bool IsSubset(std::span<const int> A, std::span<const int> B) {
         size_t i = 0, j = 0;
         while (i < A.size() && j < B.size()) {
             if (A[i] == B[j]) { ++i; ++j; }
@@ -0,0 +1,169 @@
+#ifndef AUTOLABA_SPATIALINDEX_H
+#define AUTOLABA_SPATIALINDEX_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Layout.h"
+
+// равномерная сетка над раскладкой: по прямоугольнику окна находятся только видимые вершины и ребра
+
+// прямоугольник в нормализованных координатах раскладки
+struct WorldRect {
+    float x0 = -1.0f;
+    float y0 = -1.0f;
+    float x1 = 1.0f;
+    float y1 = 1.0f;
+};
+
+class SpatialGrid {
+private:
+    float x0_ = 0.0f;
+    float y0_ = 0.0f;
+    float cellWidth_ = 1.0f;
+    float cellHeight_ = 1.0f;
+    int columns_ = 0;
+    int rows_ = 0;
+    std::vector<int> vertexOffsets_;  // ячейка -> позиции в vertices (CSR), вершина лежит в ячейке центра
+    std::vector<int> vertexItems_;
+    std::vector<int> segmentOffsets_; // ячейка -> позиции в segments; отрезок записан во все ячейки, которые пересекает
+    std::vector<int> segmentItems_;
+    mutable std::vector<unsigned> stamp_; // отметка последнего запроса для каждого отрезка - без повторов в ответе
+    mutable unsigned epoch_ = 0;
+
+    int Column(float x) const { return std::clamp(static_cast<int>((x - x0_) / cellWidth_), 0, columns_ - 1); }
+    int Row(float y) const { return std::clamp(static_cast<int>((y - y0_) / cellHeight_), 0, rows_ - 1); }
+
+    // ячейки, через которые проходит отрезок: по столбцам, в каждом - диапазон строк
+    template <class Visit>
+    void ForEachCell(const EdgeSegment& e, Visit&& visit) const {
+        float ax = e.x0, ay = e.y0, bx = e.x1, by = e.y1;
+        if (ax > bx) {
+            std::swap(ax, bx);
+            std::swap(ay, by);
+        }
+        const int c0 = Column(ax);
+        const int c1 = Column(bx);
+        const float slope = bx > ax ? (by - ay) / (bx - ax) : 0.0f;
+        for (int c = c0; c <= c1; ++c) {
+            const float left = c == c0 ? ax : x0_ + static_cast<float>(c) * cellWidth_;
+            const float right = c == c1 ? bx : x0_ + static_cast<float>(c + 1) * cellWidth_;
+            float ya = c == c0 ? ay : ay + (left - ax) * slope;
+            float yb = c == c1 ? by : ay + (right - ax) * slope;
+            if (ya > yb) std::swap(ya, yb);
+            for (int r = Row(ya), last = Row(yb); r <= last; ++r) visit(r * columns_ + c);
+        }
+    }
+
+public:
+    bool Empty() const { return columns_ == 0; }
+    int CellCount() const { return columns_ * rows_; }
+
+    // около четырех вершин на ячейку; сторона сетки ограничена, чтобы пустые ячейки не съедали память
+    void Build(const std::vector<DrawVertex>& vertices, const std::vector<EdgeSegment>& segments) {
+        if (vertices.empty()) {
+            *this = SpatialGrid();
+            return;
+        }
+        float minX = vertices[0].x, maxX = minX, minY = vertices[0].y, maxY = minY;
+        for (const DrawVertex& v : vertices) {
+            minX = std::min(minX, v.x);
+            maxX = std::max(maxX, v.x);
+            minY = std::min(minY, v.y);
+            maxY = std::max(maxY, v.y);
+        }
+        const int side = std::clamp(static_cast<int>(std::sqrt(static_cast<double>(vertices.size()) / 4.0)), 1, 1024);
+        columns_ = rows_ = side;
+        x0_ = minX;
+        y0_ = minY;
+        cellWidth_ = std::max(maxX - minX, 1e-6f) / static_cast<float>(side);
+        cellHeight_ = std::max(maxY - minY, 1e-6f) / static_cast<float>(side);
+
+        const int cells = CellCount();
+        vertexOffsets_.assign(cells + 1, 0);
+        for (const DrawVertex& v : vertices) ++vertexOffsets_[Row(v.y) * columns_ + Column(v.x) + 1];
+        for (int c = 0; c < cells; ++c) vertexOffsets_[c + 1] += vertexOffsets_[c];
+        vertexItems_.resize(vertices.size());
+        std::vector<int> cursor(vertexOffsets_.begin(), vertexOffsets_.end() - 1);
+        for (int i = 0; i < static_cast<int>(vertices.size()); ++i)
+            vertexItems_[cursor[Row(vertices[i].y) * columns_ + Column(vertices[i].x)]++] = i;
+
+        segmentOffsets_.assign(cells + 1, 0);
+        for (const EdgeSegment& e : segments) ForEachCell(e, [this](int cell) { ++segmentOffsets_[cell + 1]; });
+        for (int c = 0; c < cells; ++c) segmentOffsets_[c + 1] += segmentOffsets_[c];
+        segmentItems_.resize(segmentOffsets_[cells]);
+        cursor.assign(segmentOffsets_.begin(), segmentOffsets_.end() - 1);
+        for (int i = 0; i < static_cast<int>(segments.size()); ++i)
+            ForEachCell(segments[i], [&](int cell) { segmentItems_[cursor[cell]++] = i; });
+        stamp_.assign(segments.size(), 0);
+        epoch_ = 0;
+    }
+
+    // число ячеек, которые задевает прямоугольник: по нему решается, стоит ли отбирать или проще нарисовать все
+    int CellsIn(const WorldRect& rect) const {
+        if (Empty()) return 0;
+        return (Column(rect.x1) - Column(rect.x0) + 1) * (Row(rect.y1) - Row(rect.y0) + 1);
+    }
+
+    // ближайшая к (x, y) вершина не дальше maxDistance (позиция в vertices) или -1; смотрятся только ячейки вокруг точки
+    int Nearest(const std::vector<DrawVertex>& vertices, float x, float y, float maxDistance) const {
+        if (Empty() || x < x0_ - maxDistance || y < y0_ - maxDistance ||
+            x > x0_ + static_cast<float>(columns_) * cellWidth_ + maxDistance ||
+            y > y0_ + static_cast<float>(rows_) * cellHeight_ + maxDistance) return -1;
+        int best = -1;
+        float bestDistance = maxDistance * maxDistance;
+        for (int r = Row(y - maxDistance), r1 = Row(y + maxDistance); r <= r1; ++r) {
+            for (int c = Column(x - maxDistance), c1 = Column(x + maxDistance); c <= c1; ++c) {
+                const int cell = r * columns_ + c;
+                for (int k = vertexOffsets_[cell]; k < vertexOffsets_[cell + 1]; ++k) {
+                    const DrawVertex& v = vertices[vertexItems_[k]];
+                    const float d = (v.x - x) * (v.x - x) + (v.y - y) * (v.y - y);
+                    if (d <= bestDistance) {
+                        bestDistance = d;
+                        best = vertexItems_[k];
+                    }
+                }
+            }
+        }
+        return best;
+    }
+
+    // вершины (с центром в rect) и отрезки (проходящие через ячейки rect); массивы ответа перезаписываются
+    void Query(const WorldRect& rect, std::vector<int>& vertices, std::vector<int>& segments) const {
+        Query(rect, vertices, segments, stamp_, epoch_);
+    }
+    // то же со своими отметками (stamp размером в число отрезков): так запросы можно вести из нескольких потоков
+    void Query(const WorldRect& rect, std::vector<int>& vertices, std::vector<int>& segments,
+               std::vector<unsigned>& stamp, unsigned& epoch) const {
+        vertices.clear();
+        segments.clear();
+        if (Empty() || rect.x1 < x0_ || rect.y1 < y0_ || rect.x0 > x0_ + static_cast<float>(columns_) * cellWidth_ ||
+            rect.y0 > y0_ + static_cast<float>(rows_) * cellHeight_) return;
+        if (stamp.size() != stamp_.size()) {
+            stamp.assign(stamp_.size(), 0);
+            epoch = 0;
+        }
+        if (++epoch == 0) {
+            std::fill(stamp.begin(), stamp.end(), 0);
+            epoch = 1;
+        }
+        const int c0 = Column(rect.x0), c1 = Column(rect.x1);
+        const int r0 = Row(rect.y0), r1 = Row(rect.y1);
+        for (int r = r0; r <= r1; ++r) {
+            for (int c = c0; c <= c1; ++c) {
+                const int cell = r * columns_ + c;
+                vertices.insert(vertices.end(), vertexItems_.begin() + vertexOffsets_[cell],
+                                vertexItems_.begin() + vertexOffsets_[cell + 1]);
+                for (int k = segmentOffsets_[cell]; k < segmentOffsets_[cell + 1]; ++k) {
+                    const int s = segmentItems_[k];
+                    if (stamp[s] == epoch) continue;
+                    stamp[s] = epoch;
+                    segments.push_back(s);
+                }
+            }
+        }
+    }
+};
+
+#endif //AUTOLABA_SPATIALINDEX_H
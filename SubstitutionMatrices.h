@@ -0,0 +1,254 @@
+#ifndef AUTOLABA_SUBSTITUTIONMATRICES_H
+#define AUTOLABA_SUBSTITUTIONMATRICES_H
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "MappedFile.h"
+
+/*
+ * Таблицы замен аминокислот. Стандартные матрицы (NCBI) встроены в программу и собираются в плоский вид
+ * на этапе компиляции - по умолчанию при запуске нет ни чтения файлов, ни разбора.
+ * Свои матрицы читаются из CSV в тот же плоский формат.
+ */
+
+inline constexpr int MaxResidues = 32;               // строка таблицы - 32 байта, код символа сдвигом на 5
+inline constexpr std::uint8_t UnknownResidue = 0xFF; // код символа, которого нет в таблице
+
+// символ кодируется один раз, дальше значение для пары кодов - одно чтение из плоского массива
+struct SubstitutionTable {
+    std::array<std::uint8_t, 256> code {};                                // символ -> код или UnknownResidue
+    alignas(64) std::array<std::int8_t, MaxResidues * MaxResidues> matrix {}; // [код1 * MaxResidues + код2]
+    std::array<char, MaxResidues> letters {};                             // символы в порядке кодов
+    int size = 0;
+
+    constexpr SubstitutionTable() { code.fill(UnknownResidue); }
+
+    constexpr const std::int8_t* Row(std::uint8_t a) const { return matrix.data() + a * MaxResidues; }
+    constexpr int Score(std::uint8_t a, std::uint8_t b) const { return matrix[a * MaxResidues + b]; }
+    constexpr bool Has(char c) const { return code[static_cast<unsigned char>(c)] != UnknownResidue; }
+
+    constexpr void AddLetter(char c) {
+        if (size == MaxResidues) throw std::runtime_error("Too many letters in the substitution matrix");
+        if (Has(c)) throw std::runtime_error(std::string("Letter repeats in the substitution matrix: ") + c);
+        code[static_cast<unsigned char>(c)] = static_cast<std::uint8_t>(size);
+        letters[size++] = c;
+    }
+};
+
+// стандартная матрица 20x20 в порядке NCBI
+struct StandardMatrix {
+    std::string_view name;
+    std::array<std::int8_t, 400> values;
+};
+
+inline constexpr std::string_view StandardLetters = "ARNDCQEGHILKMFPSTWYV";
+
+inline constexpr StandardMatrix Blosum62 {"blosum62", {{
+      4,  -1,  -2,  -2,   0,  -1,  -1,   0,  -2,  -1,  -1,  -1,  -1,  -2,  -1,   1,   0,  -3,  -2,   0,  // A
+     -1,   5,   0,  -2,  -3,   1,   0,  -2,   0,  -3,  -2,   2,  -1,  -3,  -2,  -1,  -1,  -3,  -2,  -3,  // R
+     -2,   0,   6,   1,  -3,   0,   0,   0,   1,  -3,  -3,   0,  -2,  -3,  -2,   1,   0,  -4,  -2,  -3,  // N
+     -2,  -2,   1,   6,  -3,   0,   2,  -1,  -1,  -3,  -4,  -1,  -3,  -3,  -1,   0,  -1,  -4,  -3,  -3,  // D
+      0,  -3,  -3,  -3,   9,  -3,  -4,  -3,  -3,  -1,  -1,  -3,  -1,  -2,  -3,  -1,  -1,  -2,  -2,  -1,  // C
+     -1,   1,   0,   0,  -3,   5,   2,  -2,   0,  -3,  -2,   1,   0,  -3,  -1,   0,  -1,  -2,  -1,  -2,  // Q
+     -1,   0,   0,   2,  -4,   2,   5,  -2,   0,  -3,  -3,   1,  -2,  -3,  -1,   0,  -1,  -3,  -2,  -2,  // E
+      0,  -2,   0,  -1,  -3,  -2,  -2,   6,  -2,  -4,  -4,  -2,  -3,  -3,  -2,   0,  -2,  -2,  -3,  -3,  // G
+     -2,   0,   1,  -1,  -3,   0,   0,  -2,   8,  -3,  -3,  -1,  -2,  -1,  -2,  -1,  -2,  -2,   2,  -3,  // H
+     -1,  -3,  -3,  -3,  -1,  -3,  -3,  -4,  -3,   4,   2,  -3,   1,   0,  -3,  -2,  -1,  -3,  -1,   3,  // I
+     -1,  -2,  -3,  -4,  -1,  -2,  -3,  -4,  -3,   2,   4,  -2,   2,   0,  -3,  -2,  -1,  -2,  -1,   1,  // L
+     -1,   2,   0,  -1,  -3,   1,   1,  -2,  -1,  -3,  -2,   5,  -1,  -3,  -1,   0,  -1,  -3,  -2,  -2,  // K
+     -1,  -1,  -2,  -3,  -1,   0,  -2,  -3,  -2,   1,   2,  -1,   5,   0,  -2,  -1,  -1,  -1,  -1,   1,  // M
+     -2,  -3,  -3,  -3,  -2,  -3,  -3,  -3,  -1,   0,   0,  -3,   0,   6,  -4,  -2,  -2,   1,   3,  -1,  // F
+     -1,  -2,  -2,  -1,  -3,  -1,  -1,  -2,  -2,  -3,  -3,  -1,  -2,  -4,   7,  -1,  -1,  -4,  -3,  -2,  // P
+      1,  -1,   1,   0,  -1,   0,   0,   0,  -1,  -2,  -2,   0,  -1,  -2,  -1,   4,   1,  -3,  -2,  -2,  // S
+      0,  -1,   0,  -1,  -1,  -1,  -1,  -2,  -2,  -1,  -1,  -1,  -1,  -2,  -1,   1,   5,  -2,  -2,   0,  // T
+     -3,  -3,  -4,  -4,  -2,  -2,  -3,  -2,  -2,  -3,  -2,  -3,  -1,   1,  -4,  -3,  -2,  11,   2,  -3,  // W
+     -2,  -2,  -2,  -3,  -2,  -1,  -2,  -3,   2,  -1,  -1,  -2,  -1,   3,  -3,  -2,  -2,   2,   7,  -1,  // Y
+      0,  -3,  -3,  -3,  -1,  -2,  -2,  -3,  -3,   3,   1,  -2,   1,  -1,  -2,  -2,   0,  -3,  -1,   4,  // V
+}}};
+
+inline constexpr StandardMatrix Blosum45 {"blosum45", {{
+      5,  -2,  -1,  -2,  -1,  -1,  -1,   0,  -2,  -1,  -1,  -1,  -1,  -2,  -1,   1,   0,  -2,  -2,   0,  // A
+     -2,   7,   0,  -1,  -3,   1,   0,  -2,   0,  -3,  -2,   3,  -1,  -2,  -2,  -1,  -1,  -2,  -1,  -2,  // R
+     -1,   0,   6,   2,  -2,   0,   0,   0,   1,  -2,  -3,   0,  -2,  -2,  -2,   1,   0,  -4,  -2,  -3,  // N
+     -2,  -1,   2,   7,  -3,   0,   2,  -1,   0,  -4,  -3,   0,  -3,  -4,  -1,   0,  -1,  -4,  -2,  -3,  // D
+     -1,  -3,  -2,  -3,  12,  -3,  -3,  -3,  -3,  -3,  -2,  -3,  -2,  -2,  -4,  -1,  -1,  -5,  -3,  -1,  // C
+     -1,   1,   0,   0,  -3,   6,   2,  -2,   1,  -2,  -2,   1,   0,  -4,  -1,   0,  -1,  -2,  -1,  -3,  // Q
+     -1,   0,   0,   2,  -3,   2,   6,  -2,   0,  -3,  -2,   1,  -2,  -3,   0,   0,  -1,  -3,  -2,  -3,  // E
+      0,  -2,   0,  -1,  -3,  -2,  -2,   7,  -2,  -4,  -3,  -2,  -2,  -3,  -2,   0,  -2,  -2,  -3,  -3,  // G
+     -2,   0,   1,   0,  -3,   1,   0,  -2,  10,  -3,  -2,  -1,   0,  -2,  -2,  -1,  -2,  -3,   2,  -3,  // H
+     -1,  -3,  -2,  -4,  -3,  -2,  -3,  -4,  -3,   5,   2,  -3,   2,   0,  -2,  -2,  -1,  -2,   0,   3,  // I
+     -1,  -2,  -3,  -3,  -2,  -2,  -2,  -3,  -2,   2,   5,  -3,   2,   1,  -3,  -3,  -1,  -2,   0,   1,  // L
+     -1,   3,   0,   0,  -3,   1,   1,  -2,  -1,  -3,  -3,   5,  -1,  -3,  -1,  -1,  -1,  -2,  -1,  -2,  // K
+     -1,  -1,  -2,  -3,  -2,   0,  -2,  -2,   0,   2,   2,  -1,   6,   0,  -2,  -2,  -1,  -2,   0,   1,  // M
+     -2,  -2,  -2,  -4,  -2,  -4,  -3,  -3,  -2,   0,   1,  -3,   0,   8,  -3,  -2,  -1,   1,   3,   0,  // F
+     -1,  -2,  -2,  -1,  -4,  -1,   0,  -2,  -2,  -2,  -3,  -1,  -2,  -3,   9,  -1,  -1,  -3,  -3,  -3,  // P
+      1,  -1,   1,   0,  -1,   0,   0,   0,  -1,  -2,  -3,  -1,  -2,  -2,  -1,   4,   2,  -4,  -2,  -1,  // S
+      0,  -1,   0,  -1,  -1,  -1,  -1,  -2,  -2,  -1,  -1,  -1,  -1,  -1,  -1,   2,   5,  -3,  -1,   0,  // T
+     -2,  -2,  -4,  -4,  -5,  -2,  -3,  -2,  -3,  -2,  -2,  -2,  -2,   1,  -3,  -4,  -3,  15,   3,  -3,  // W
+     -2,  -1,  -2,  -2,  -3,  -1,  -2,  -3,   2,   0,   0,  -1,   0,   3,  -3,  -2,  -1,   3,   8,  -1,  // Y
+      0,  -2,  -3,  -3,  -1,  -3,  -3,  -3,  -3,   3,   1,  -2,   1,   0,  -3,  -1,   0,  -3,  -1,   5,  // V
+}}};
+
+inline constexpr StandardMatrix Blosum80 {"blosum80", {{
+      7,  -3,  -3,  -3,  -1,  -2,  -2,   0,  -3,  -3,  -3,  -1,  -2,  -4,  -1,   2,   0,  -5,  -4,  -1,  // A
+     -3,   9,  -1,  -3,  -6,   1,  -1,  -4,   0,  -5,  -4,   3,  -3,  -5,  -3,  -2,  -2,  -5,  -4,  -4,  // R
+     -3,  -1,   9,   2,  -5,   0,  -1,  -1,   1,  -6,  -6,   0,  -4,  -6,  -4,   1,   0,  -7,  -4,  -5,  // N
+     -3,  -3,   2,  10,  -7,  -1,   2,  -3,  -2,  -7,  -7,  -2,  -6,  -6,  -3,  -1,  -2,  -8,  -6,  -6,  // D
+     -1,  -6,  -5,  -7,  13,  -5,  -7,  -6,  -7,  -2,  -3,  -6,  -3,  -4,  -6,  -2,  -2,  -5,  -5,  -2,  // C
+     -2,   1,   0,  -1,  -5,   9,   3,  -4,   1,  -5,  -4,   2,  -1,  -5,  -3,  -1,  -1,  -4,  -3,  -4,  // Q
+     -2,  -1,  -1,   2,  -7,   3,   8,  -4,   0,  -6,  -6,   1,  -4,  -6,  -2,  -1,  -2,  -6,  -5,  -4,  // E
+      0,  -4,  -1,  -3,  -6,  -4,  -4,   9,  -4,  -7,  -7,  -3,  -5,  -6,  -5,  -1,  -3,  -6,  -6,  -6,  // G
+     -3,   0,   1,  -2,  -7,   1,   0,  -4,  12,  -6,  -5,  -1,  -4,  -2,  -4,  -2,  -3,  -4,   3,  -5,  // H
+     -3,  -5,  -6,  -7,  -2,  -5,  -6,  -7,  -6,   7,   2,  -5,   2,  -1,  -5,  -4,  -2,  -5,  -3,   4,  // I
+     -3,  -4,  -6,  -7,  -3,  -4,  -6,  -7,  -5,   2,   6,  -4,   3,   0,  -5,  -4,  -3,  -4,  -2,   1,  // L
+     -1,   3,   0,  -2,  -6,   2,   1,  -3,  -1,  -5,  -4,   8,  -3,  -5,  -2,  -1,  -1,  -6,  -4,  -4,  // K
+     -2,  -3,  -4,  -6,  -3,  -1,  -4,  -5,  -4,   2,   3,  -3,   9,   0,  -4,  -3,  -1,  -3,  -3,   1,  // M
+     -4,  -5,  -6,  -6,  -4,  -5,  -6,  -6,  -2,  -1,   0,  -5,   0,  10,  -6,  -4,  -4,   0,   4,  -2,  // F
+     -1,  -3,  -4,  -3,  -6,  -3,  -2,  -5,  -4,  -5,  -5,  -2,  -4,  -6,  12,  -2,  -3,  -7,  -6,  -4,  // P
+      2,  -2,   1,  -1,  -2,  -1,  -1,  -1,  -2,  -4,  -4,  -1,  -3,  -4,  -2,   7,   2,  -6,  -3,  -3,  // S
+      0,  -2,   0,  -2,  -2,  -1,  -2,  -3,  -3,  -2,  -3,  -1,  -1,  -4,  -3,   2,   8,  -5,  -3,   0,  // T
+     -5,  -5,  -7,  -8,  -5,  -4,  -6,  -6,  -4,  -5,  -4,  -6,  -3,   0,  -7,  -6,  -5,  16,   3,  -5,  // W
+     -4,  -4,  -4,  -6,  -5,  -3,  -5,  -6,   3,  -3,  -2,  -4,  -3,   4,  -6,  -3,  -3,   3,  11,  -3,  // Y
+     -1,  -4,  -5,  -6,  -2,  -4,  -4,  -6,  -5,   4,   1,  -4,   1,  -2,  -4,  -3,   0,  -5,  -3,   7,  // V
+}}};
+
+inline constexpr StandardMatrix Pam250 {"pam250", {{
+      2,  -2,   0,   0,  -2,   0,   0,   1,  -1,  -1,  -2,  -1,  -1,  -3,   1,   1,   1,  -6,  -3,   0,  // A
+     -2,   6,   0,  -1,  -4,   1,  -1,  -3,   2,  -2,  -3,   3,   0,  -4,   0,   0,  -1,   2,  -4,  -2,  // R
+      0,   0,   2,   2,  -4,   1,   1,   0,   2,  -2,  -3,   1,  -2,  -3,   0,   1,   0,  -4,  -2,  -2,  // N
+      0,  -1,   2,   4,  -5,   2,   3,   1,   1,  -2,  -4,   0,  -3,  -6,  -1,   0,   0,  -7,  -4,  -2,  // D
+     -2,  -4,  -4,  -5,  12,  -5,  -5,  -3,  -3,  -2,  -6,  -5,  -5,  -4,  -3,   0,  -2,  -8,   0,  -2,  // C
+      0,   1,   1,   2,  -5,   4,   2,  -1,   3,  -2,  -2,   1,  -1,  -5,   0,  -1,  -1,  -5,  -4,  -2,  // Q
+      0,  -1,   1,   3,  -5,   2,   4,   0,   1,  -2,  -3,   0,  -2,  -5,  -1,   0,   0,  -7,  -4,  -2,  // E
+      1,  -3,   0,   1,  -3,  -1,   0,   5,  -2,  -3,  -4,  -2,  -3,  -5,   0,   1,   0,  -7,  -5,  -1,  // G
+     -1,   2,   2,   1,  -3,   3,   1,  -2,   6,  -2,  -2,   0,  -2,  -2,   0,  -1,  -1,  -3,   0,  -2,  // H
+     -1,  -2,  -2,  -2,  -2,  -2,  -2,  -3,  -2,   5,   2,  -2,   2,   1,  -2,  -1,   0,  -5,  -1,   4,  // I
+     -2,  -3,  -3,  -4,  -6,  -2,  -3,  -4,  -2,   2,   6,  -3,   4,   2,  -3,  -3,  -2,  -2,  -1,   2,  // L
+     -1,   3,   1,   0,  -5,   1,   0,  -2,   0,  -2,  -3,   5,   0,  -5,  -1,   0,   0,  -3,  -4,  -2,  // K
+     -1,   0,  -2,  -3,  -5,  -1,  -2,  -3,  -2,   2,   4,   0,   6,   0,  -2,  -2,  -1,  -4,  -2,   2,  // M
+     -3,  -4,  -3,  -6,  -4,  -5,  -5,  -5,  -2,   1,   2,  -5,   0,   9,  -5,  -3,  -3,   0,   7,  -1,  // F
+      1,   0,   0,  -1,  -3,   0,  -1,   0,   0,  -2,  -3,  -1,  -2,  -5,   6,   1,   0,  -6,  -5,  -1,  // P
+      1,   0,   1,   0,   0,  -1,   0,   1,  -1,  -1,  -3,   0,  -2,  -3,   1,   2,   1,  -2,  -3,  -1,  // S
+      1,  -1,   0,   0,  -2,  -1,   0,   0,  -1,   0,  -2,   0,  -1,  -3,   0,   1,   3,  -5,  -3,   0,  // T
+     -6,   2,  -4,  -7,  -8,  -5,  -7,  -7,  -3,  -5,  -2,  -3,  -4,   0,  -6,  -2,  -5,  17,   0,  -6,  // W
+     -3,  -4,  -2,  -4,   0,  -4,  -4,  -5,   0,  -1,  -1,  -4,  -2,   7,  -5,  -3,  -3,   0,  10,  -2,  // Y
+      0,  -2,  -2,  -2,  -2,  -2,  -2,  -1,  -2,   4,   2,  -2,   2,  -1,  -1,  -1,   0,  -6,  -2,   4,  // V
+}}};
+
+inline constexpr std::array<const StandardMatrix*, 4> StandardMatrices {&Blosum62, &Blosum45, &Blosum80, &Pam250};
+
+constexpr SubstitutionTable MakeTable(const StandardMatrix& m) {
+    SubstitutionTable table;
+    for (char c : StandardLetters) table.AddLetter(c);
+    for (int i = 0; i < 20; ++i) {
+        for (int j = 0; j < 20; ++j) table.matrix[i * MaxResidues + j] = m.values[i * 20 + j];
+    }
+    return table;
+}
+
+// таблица по умолчанию готова уже в бинарнике
+inline constexpr SubstitutionTable Blosum62Table = MakeTable(Blosum62);
+
+// стандартная матрица по имени без учета регистра: blosum62, blosum45, blosum80, pam250; nullptr - такой нет
+inline const StandardMatrix* FindStandardMatrix(std::string_view name) {
+    for (const StandardMatrix* m : StandardMatrices) {
+        if (m->name.size() != name.size()) continue;
+        bool same = true;
+        for (std::size_t k = 0; k < name.size() && same; ++k) {
+            same = m->name[k] == (name[k] >= 'A' && name[k] <= 'Z' ? name[k] - 'A' + 'a' : name[k]);
+        }
+        if (same) return m;
+    }
+    return nullptr;
+}
+
+/*
+ * CSV с матрицей: первая строка - пустая ячейка и буквы, дальше строки "буква;числа...".
+ * Разделитель - ';', ',', табуляция или пробелы (подходят и файлы NCBI); числа читаются std::from_chars.
+ * Значения должны помещаться в int8, а строки - идти в том же порядке, что и буквы заголовка.
+ */
+inline SubstitutionTable ParseSubstitutionCsv(std::string_view text) {
+    SubstitutionTable table;
+    std::size_t pos = 0;
+    int line = 0;
+    auto fail = [&](const std::string& what) -> void {
+        throw std::runtime_error("Substitution matrix, line " + std::to_string(line) + ": " + what);
+    };
+    auto separator = [](char c) { return c == ';' || c == ',' || c == '\t' || c == ' ' || c == '\r'; };
+    // ячейки одной строки: пустые ячейки между разделителями ';'/',' сохраняются (первая ячейка заголовка пуста)
+    auto cells = [&](std::string_view row) {
+        std::vector<std::string_view> result;
+        std::size_t k = 0;
+        while (k < row.size()) {
+            while (k < row.size() && (row[k] == ' ' || row[k] == '\t' || row[k] == '\r')) ++k;
+            std::size_t end = k;
+            while (end < row.size() && !separator(row[end])) ++end;
+            if (end > k || (end < row.size() && (row[end] == ';' || row[end] == ','))) result.push_back(row.substr(k, end - k));
+            k = end;
+            while (k < row.size() && (row[k] == ' ' || row[k] == '\t' || row[k] == '\r')) ++k;
+            if (k < row.size() && (row[k] == ';' || row[k] == ',')) ++k;
+        }
+        return result;
+    };
+    auto nextLine = [&]() {
+        std::size_t end = text.find('\n', pos);
+        if (end == std::string_view::npos) end = text.size();
+        const std::string_view row = text.substr(pos, end - pos);
+        pos = end + 1;
+        ++line;
+        return row;
+    };
+
+    std::vector<std::string_view> header;
+    while (header.empty() && pos < text.size()) {
+        const std::string_view row = nextLine();
+        if (row.empty() || row[0] != '#') header = cells(row); // строки '#' - комментарии, как в файлах NCBI
+    }
+    if (!header.empty() && header[0].empty()) header.erase(header.begin());
+    if (header.empty()) fail("no header");
+    for (std::string_view letter : header) {
+        if (letter.size() != 1) fail("header cell is not a single letter");
+        table.AddLetter(letter[0]);
+    }
+
+    int rows = 0;
+    while (pos < text.size()) {
+        const std::string_view line = nextLine();
+        if (!line.empty() && line[0] == '#') continue;
+        const std::vector<std::string_view> row = cells(line);
+        if (row.empty()) continue;
+        if (rows == table.size) fail("too many rows");
+        if (row[0].size() != 1 || row[0][0] != table.letters[rows]) fail("row letter does not match the header");
+        if (static_cast<int>(row.size()) != table.size + 1) fail("wrong number of values");
+        for (int j = 0; j < table.size; ++j) {
+            int value = 0;
+            const std::string_view cell = row[j + 1];
+            const auto [end, error] = std::from_chars(cell.data(), cell.data() + cell.size(), value);
+            if (error != std::errc() || end != cell.data() + cell.size()) fail("bad number '" + std::string(cell) + "'");
+            if (value < -128 || value > 127) fail("value out of range");
+            table.matrix[rows * MaxResidues + j] = static_cast<std::int8_t>(value);
+        }
+        ++rows;
+    }
+    if (rows != table.size) fail("too few rows");
+    return table;
+}
+
+inline SubstitutionTable LoadSubstitutionCsv(const std::string& path) {
+    const MappedFile file(path);
+    return ParseSubstitutionCsv(std::string_view(reinterpret_cast<const char*>(file.Data()), file.Size()));
+}
+
+// имя стандартной матрицы или путь к CSV
+inline SubstitutionTable LoadSubstitutionMatrix(const std::string& nameOrPath) {
+    if (const StandardMatrix* m = FindStandardMatrix(nameOrPath)) return MakeTable(*m);
+    return LoadSubstitutionCsv(nameOrPath);
+}
+
+#endif //AUTOLABA_SUBSTITUTIONMATRICES_H
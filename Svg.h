@@ -0,0 +1,120 @@
+#ifndef AUTOLABA_SVG_H
+#define AUTOLABA_SVG_H
+
+#include <cmath>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "Export.h"
+#include "HasseBuilder.h"
+#include "Layout.h"
+
+// векторный вывод диаграммы по тем же координатам, что и окно: пишется потоком, без DOM в памяти
+
+struct SvgStyle {
+    int width = 600;
+    int height = 600;
+    const char* background = "#ffffff";
+    const char* edge = "#000000";
+    const char* vertex = "#ffc0cb";
+    const char* text = "#000000";
+    int edgesPerPath = 4096; // ребра собираются в один <path>, но не бесконечно длинный
+};
+
+// точка в координатах изображения: (x, y) из [-1, 1], ось y вверх, как в glVertex2f
+inline void WriteSvgPoint(BufferedWriter& out, const SvgStyle& style, float x, float y) {
+    out.WriteFixed((x + 1.0) * 0.5 * style.width, 2);
+    out.Put(' ');
+    out.WriteFixed((1.0 - y) * 0.5 * style.height, 2);
+}
+inline void WriteSvgText(BufferedWriter& out, const SvgStyle& style, float x, float y, std::string_view label) {
+    out.Write("<text x=\"");
+    out.WriteFixed((x + 1.0) * 0.5 * style.width, 2);
+    out.Write("\" y=\"");
+    out.WriteFixed((1.0 - y) * 0.5 * style.height, 2);
+    out.Write("\">");
+    WriteXmlText(out, label);
+    out.Write("</text>\n");
+}
+
+// edgeScores (если не пуст) идет параллельно edges и подписывается у середины ребра, как в DrawHasseBio
+inline void WriteSvg(const std::string& path, const std::vector<DrawVertex>& vertices,
+                     const std::vector<HasseBuilder::Edge>& edges, float radius,
+                     std::span<const int> edgeScores = {}, const SvgStyle& style = {}) {
+    BufferedWriter out(path);
+    const std::vector<EdgeSegment> segments = EdgeGeometry(vertices, edges);
+    const double fontSize = 0.03 * style.height;
+
+    out.Write("<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" width=\"");
+    out.WriteInt(style.width);
+    out.Write("\" height=\"");
+    out.WriteInt(style.height);
+    out.Write("\" viewBox=\"0 0 ");
+    out.WriteInt(style.width);
+    out.Put(' ');
+    out.WriteInt(style.height);
+    out.Write("\">\n<defs><circle id=\"v\" r=\"");
+    out.WriteFixed(radius * 0.5 * style.width, 2);
+    out.Write("\" fill=\"");
+    out.Write(style.vertex);
+    out.Write("\"/></defs>\n<rect width=\"100%\" height=\"100%\" fill=\"");
+    out.Write(style.background);
+    out.Write("\"/>\n");
+
+    // ребра: отрезки M x y L x y, по edgesPerPath штук в одном пути
+    out.Write("<g stroke=\"");
+    out.Write(style.edge);
+    out.Write("\" stroke-width=\"1\" fill=\"none\">\n");
+    int inPath = 0;
+    for (const EdgeSegment& e : segments) {
+        if (inPath == 0) out.Write("<path d=\"");
+        else out.Put(' ');
+        out.Put('M');
+        WriteSvgPoint(out, style, e.x0, e.y0);
+        out.Put('L');
+        WriteSvgPoint(out, style, e.x1, e.y1);
+        if (++inPath == style.edgesPerPath) {
+            out.Write("\"/>\n");
+            inPath = 0;
+        }
+    }
+    if (inPath > 0) out.Write("\"/>\n");
+    out.Write("</g>\n");
+
+    // вершины: одно определение круга и короткая ссылка на каждую вершину
+    out.Write("<g>\n");
+    for (const auto& v : vertices) {
+        out.Write("<use xlink:href=\"#v\" x=\"");
+        out.WriteFixed((v.x + 1.0) * 0.5 * style.width, 2);
+        out.Write("\" y=\"");
+        out.WriteFixed((1.0 - v.y) * 0.5 * style.height, 2);
+        out.Write("\"/>\n");
+    }
+    out.Write("</g>\n");
+
+    out.Write("<g font-family=\"Times New Roman, serif\" font-size=\"");
+    out.WriteFixed(fontSize, 1);
+    out.Write("\" text-anchor=\"middle\" fill=\"");
+    out.Write(style.text);
+    out.Write("\">\n");
+    for (const auto& v : vertices) WriteSvgText(out, style, v.x, v.y - (radius + 0.05f), v.string);
+    if (!edgeScores.empty()) {
+        std::string label;
+        for (const EdgeSegment& e : segments) {
+            if (e.edge >= static_cast<int>(edgeScores.size())) continue;
+            const float dx = e.x1 - e.x0;
+            const float dy = e.y1 - e.y0;
+            const float len = std::sqrt(dx * dx + dy * dy);
+            if (len <= 0.0f) continue;
+            const float offset = 0.05f;
+            label = std::to_string(edgeScores[e.edge]);
+            WriteSvgText(out, style, (e.x0 + e.x1) * 0.5f - dy / len * offset,
+                         (e.y0 + e.y1) * 0.5f + dx / len * offset, label);
+        }
+    }
+    out.Write("</g>\n</svg>\n");
+    out.Close();
+}
+
+#endif //AUTOLABA_SVG_H
@@ -0,0 +1,200 @@
+#ifndef AUTOLABA_TEXTATLAS_H
+#define AUTOLABA_TEXTATLAS_H
+
+#include <cmath>
+#include <string_view>
+#include <vector>
+
+#include "BitmapFont.h"
+#include "GlExt.h"
+#include "GpuGeometry.h"
+
+// подписи окна: шрифт растеризуется один раз в текстуру, подписи заранее раскладываются в четырехугольники
+
+inline constexpr int AtlasColumns = 16;                 // 95 глифов в сетке 16 x 6 ячеек
+inline constexpr int AtlasTextureWidth = 128;          // степени двойки - для старых контекстов
+inline constexpr int AtlasTextureHeight = 64;
+
+// набор подписей: для каждого символа два треугольника (anchor.xy, offset.xy, uv.xy),
+// anchor - точка в нормализованных координатах, offset - смещение в пикселях шрифта
+class TextBatch {
+private:
+    std::vector<float> vertices_;
+    GlExt gl_;
+    GLuint buffer_ = 0;
+    bool uploaded_ = false;
+
+public:
+    enum class Align { Left, Center };
+
+    TextBatch() = default;
+    TextBatch(const TextBatch&) = delete;
+    TextBatch& operator=(const TextBatch&) = delete;
+
+    // (x, y) - базовая линия; line сдвигает строку вниз на высоту ячейки (для таблиц)
+    void Add(float x, float y, std::string_view text, Align align, int line = 0) {
+        const int width = FontTextWidth(text); // ширина меряется один раз, при раскладке
+        float left = align == Align::Center ? -static_cast<float>(width / 2) : 0.0f;
+        const float bottom = -static_cast<float>(line * (FontCellHeight + 2));
+        const float top = bottom + FontGlyphHeight;
+        for (char ch : text) {
+            if (ch != ' ') {
+                const auto code = static_cast<unsigned char>(ch);
+                const int glyph = code < 32 || code > 126 ? '?' - 32 : code - 32;
+                const float u0 = static_cast<float>(glyph % AtlasColumns * FontCellWidth) / AtlasTextureWidth;
+                const float v0 = static_cast<float>(glyph / AtlasColumns * FontCellHeight) / AtlasTextureHeight;
+                const float u1 = u0 + static_cast<float>(FontGlyphWidth) / AtlasTextureWidth;
+                const float v1 = v0 + static_cast<float>(FontGlyphHeight) / AtlasTextureHeight;
+                const float right = left + FontGlyphWidth;
+                vertices_.insert(vertices_.end(), {
+                    x, y, left, bottom, u0, v1,   x, y, right, bottom, u1, v1,   x, y, right, top, u1, v0,
+                    x, y, left, bottom, u0, v1,   x, y, right, top, u1, v0,      x, y, left, top, u0, v0,
+                });
+            }
+            left += FontCellWidth;
+        }
+        uploaded_ = false;
+    }
+
+    // подписи собираются заново (например, для видимой части окна); буфер переиспользуется
+    void Clear() {
+        vertices_.clear();
+        uploaded_ = false;
+    }
+
+    int VertexCount() const { return static_cast<int>(vertices_.size() / 6); }
+    const std::vector<float>& Vertices() const { return vertices_; }
+
+    // буфер в видеопамяти; без шейдеров подписи рисуются из памяти
+    GLuint Buffer(const GlExt& gl) {
+        if (uploaded_) return buffer_;
+        uploaded_ = true;
+        if (!gl.HasShaders()) return 0;
+        gl_ = gl;
+        if (!buffer_) gl_.GenBuffers(1, &buffer_);
+        gl_.BindBuffer(GL_ARRAY_BUFFER, buffer_);
+        gl_.BufferData(GL_ARRAY_BUFFER, static_cast<std::ptrdiff_t>(vertices_.size() * sizeof(float)),
+                       vertices_.data(), GL_STATIC_DRAW);
+        gl_.BindBuffer(GL_ARRAY_BUFFER, 0);
+        return buffer_;
+    }
+    void Release() {
+        if (buffer_) gl_.DeleteBuffers(1, &buffer_);
+        buffer_ = 0;
+        uploaded_ = false;
+    }
+};
+
+// текстура шрифта и программа отрисовки подписей
+class GlyphAtlas {
+private:
+    GlExt gl_;
+    GLuint texture_ = 0;
+    GLuint program_ = 0;
+
+    // якорь привязывается к пикселю, чтобы глифы без фильтрации не расплывались
+    static constexpr const char* VertexShader = R"(#version 120
+attribute vec2 anchor;
+attribute vec2 offset;
+attribute vec2 uv;
+uniform vec4 view;
+uniform vec2 viewport;
+uniform float scale;
+varying vec2 tex;
+void main() {
+    vec2 pixel = floor(((anchor * view.xy + view.zw) * 0.5 + 0.5) * viewport + 0.5);
+    tex = uv;
+    gl_Position = vec4((pixel + offset * scale) / viewport * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+    static constexpr const char* FragmentShader = R"(#version 120
+uniform sampler2D atlas;
+uniform vec4 color;
+varying vec2 tex;
+void main() {
+    gl_FragColor = vec4(color.rgb, color.a * texture2D(atlas, tex).a);
+}
+)";
+
+public:
+    GlyphAtlas() = default;
+    GlyphAtlas(const GlyphAtlas&) = delete;
+    GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+    bool Ready() const { return texture_ != 0; }
+
+    void Create(const GlExt& gl) {
+        Release();
+        gl_ = gl;
+        std::vector<unsigned char> alpha(AtlasTextureWidth * AtlasTextureHeight, 0);
+        for (int glyph = 0; glyph < 95; ++glyph) {
+            const int cx = glyph % AtlasColumns * FontCellWidth;
+            const int cy = glyph / AtlasColumns * FontCellHeight;
+            for (int y = 0; y < FontGlyphHeight; ++y)
+                for (int x = 0; x < FontGlyphWidth; ++x)
+                    if (FontPixel(static_cast<char>(glyph + 32), x, y)) alpha[(cy + y) * AtlasTextureWidth + cx + x] = 255;
+        }
+        glGenTextures(1, &texture_);
+        glBindTexture(GL_TEXTURE_2D, texture_);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, AtlasTextureWidth, AtlasTextureHeight, 0, GL_ALPHA, GL_UNSIGNED_BYTE,
+                     alpha.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+        if (gl_.HasShaders()) program_ = BuildProgram(gl_, VertexShader, FragmentShader, {"anchor", "offset", "uv"});
+    }
+
+    void Release() {
+        if (program_) gl_.DeleteProgram(program_);
+        if (texture_) glDeleteTextures(1, &texture_);
+        program_ = 0;
+        texture_ = 0;
+    }
+
+    // весь набор - один вызов; scale - размер пикселя шрифта в пикселях экрана
+    void Draw(TextBatch& batch, const ViewTransform& view, int width, int height, int scale,
+              float r, float g, float b) const {
+        if (!texture_ || batch.VertexCount() == 0 || width <= 0 || height <= 0) return;
+        glBindTexture(GL_TEXTURE_2D, texture_);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        const GLuint buffer = program_ ? batch.Buffer(gl_) : 0;
+        if (buffer) {
+            gl_.UseProgram(program_);
+            gl_.Uniform4f(gl_.GetUniformLocation(program_, "view"), view.scaleX, view.scaleY, view.offsetX, view.offsetY);
+            gl_.Uniform2f(gl_.GetUniformLocation(program_, "viewport"), static_cast<float>(width), static_cast<float>(height));
+            gl_.Uniform1f(gl_.GetUniformLocation(program_, "scale"), static_cast<float>(scale));
+            gl_.Uniform4f(gl_.GetUniformLocation(program_, "color"), r, g, b, 1.0f);
+            gl_.Uniform1i(gl_.GetUniformLocation(program_, "atlas"), 0);
+            gl_.BindBuffer(GL_ARRAY_BUFFER, buffer);
+            const GLsizei stride = 6 * sizeof(float);
+            for (GLuint i = 0; i < 3; ++i) {
+                gl_.EnableVertexAttribArray(i);
+                gl_.VertexAttribPointer(i, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(i * 2 * sizeof(float)));
+            }
+            glDrawArrays(GL_TRIANGLES, 0, batch.VertexCount());
+            for (GLuint i = 0; i < 3; ++i) gl_.DisableVertexAttribArray(i);
+            gl_.BindBuffer(GL_ARRAY_BUFFER, 0);
+            gl_.UseProgram(0);
+        } else {
+            // старый контекст: те же четырехугольники через фиксированный конвейер
+            glEnable(GL_TEXTURE_2D);
+            glColor3f(r, g, b);
+            glBegin(GL_TRIANGLES);
+            const std::vector<float>& v = batch.Vertices();
+            for (std::size_t i = 0; i < v.size(); i += 6) {
+                const float px = std::floor(((v[i] * view.scaleX + view.offsetX) * 0.5f + 0.5f) * width + 0.5f);
+                const float py = std::floor(((v[i + 1] * view.scaleY + view.offsetY) * 0.5f + 0.5f) * height + 0.5f);
+                glTexCoord2f(v[i + 4], v[i + 5]);
+                glVertex2f((px + v[i + 2] * scale) / width * 2.0f - 1.0f, (py + v[i + 3] * scale) / height * 2.0f - 1.0f);
+            }
+            glEnd();
+            glDisable(GL_TEXTURE_2D);
+        }
+        glDisable(GL_BLEND);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+};
+
+#endif //AUTOLABA_TEXTATLAS_H
@@ -0,0 +1,191 @@
+#ifndef AUTOLABA_VIEWER_H
+#define AUTOLABA_VIEWER_H
+
+#include <atomic>
+#include <cmath>
+#define GL_SILENCE_DEPRECATION
+#include <GLFW/glfw3.h>
+#include "Camera.h"
+#include "Capture.h"
+
+// общий цикл окна просмотра: кадр рисуется только по событию, между ними поток спит в glfwWaitEvents
+
+struct ViewerOptions {
+    int width = 600;
+    int height = 600;
+    double maxFps = 0.0;                     // ограничение частоты кадров, 0 - без ограничения
+    const char* screenshot = "screenshot.png";
+};
+
+// сигнал "данные изменились" из фонового потока: Invalidate() будит цикл окна
+class ViewerSignal {
+private:
+    std::atomic<bool> dirty_ {false};
+
+public:
+    void Invalidate() {
+        dirty_.store(true);
+        glfwPostEmptyEvent();
+    }
+    bool Consume() { return dirty_.exchange(false); }
+};
+
+// что произошло с окном с прошлого кадра (заполняется обработчиками событий GLFW)
+struct ViewerState {
+    bool redraw = true;   // первый кадр рисуется всегда
+    bool capture = true;  // и снимается в файл
+    int width = 0;
+    int height = 0;
+    Camera camera;
+    bool dragging = false;  // левая кнопка зажата - перетаскивание
+    double cursorX = 0.0;   // последнее положение курсора в координатах окна
+    double cursorY = 0.0;
+    double pressX = 0.0;    // где была нажата кнопка: отпускание рядом - щелчок, а не перетаскивание
+    double pressY = 0.0;
+    bool hover = false;     // курсор сдвинулся - проверить, над какой он вершиной
+    bool click = false;
+};
+
+// курсор дальше этого (в пикселях окна) от места нажатия - уже перетаскивание; и радиус выбора вершины
+inline constexpr double ClickSlop = 4.0;
+inline constexpr float PickRadiusPixels = 6.0f;
+
+// колесо - увеличение у курсора, перетаскивание - сдвиг, стрелки и +/- - то же с клавиатуры, 0 - весь граф
+inline void HandleViewerKey(GLFWwindow* window, ViewerState& s, int key) {
+    int width, height;
+    glfwGetWindowSize(window, &width, &height);
+    const double step = 0.1 * std::min(width, height);
+    switch (key) {
+        case GLFW_KEY_LEFT: s.camera.Pan(step, 0.0, width, height); break;
+        case GLFW_KEY_RIGHT: s.camera.Pan(-step, 0.0, width, height); break;
+        case GLFW_KEY_UP: s.camera.Pan(0.0, step, width, height); break;
+        case GLFW_KEY_DOWN: s.camera.Pan(0.0, -step, width, height); break;
+        case GLFW_KEY_EQUAL:
+        case GLFW_KEY_KP_ADD: s.camera.ZoomAt(width * 0.5, height * 0.5, width, height, 1.25f); break;
+        case GLFW_KEY_MINUS:
+        case GLFW_KEY_KP_SUBTRACT: s.camera.ZoomAt(width * 0.5, height * 0.5, width, height, 0.8f); break;
+        case GLFW_KEY_0:
+        case GLFW_KEY_HOME: s.camera.Reset(); break;
+        default: break;
+    }
+}
+
+// scene.Draw(gl, width, height, camera) рисует кадр в текущем контексте, scene.Release() освобождает ресурсы GL до закрытия окна;
+// scene.Hover(x, y, radius) и scene.Select(x, y, radius) получают курсор в координатах раскладки и говорят, нужен ли кадр;
+// signal (если есть) должен жить, пока открыто окно
+template <class Scene>
+int RunViewer(const char* title, Scene& scene, const ViewerOptions& options = {}, ViewerSignal* signal = nullptr) {
+    if (!glfwInit())
+        return -1;
+    GLFWwindow* window = glfwCreateWindow(options.width, options.height, title, nullptr, nullptr);
+    if (!window) {
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+
+    ViewerState state;
+    glfwGetFramebufferSize(window, &state.width, &state.height);
+    glfwSetWindowUserPointer(window, &state);
+    glfwSetWindowRefreshCallback(window, [](GLFWwindow* w) {
+        static_cast<ViewerState*>(glfwGetWindowUserPointer(w))->redraw = true;
+    });
+    glfwSetFramebufferSizeCallback(window, [](GLFWwindow* w, int width, int height) {
+        auto* s = static_cast<ViewerState*>(glfwGetWindowUserPointer(w));
+        s->width = width;
+        s->height = height;
+        s->redraw = true;
+        s->capture = true;
+    });
+    glfwSetKeyCallback(window, [](GLFWwindow* w, int key, int, int action, int) {
+        auto* s = static_cast<ViewerState*>(glfwGetWindowUserPointer(w));
+        if (key == GLFW_KEY_S && action == GLFW_PRESS) s->capture = true;
+        if (action != GLFW_RELEASE) HandleViewerKey(w, *s, key);
+        s->redraw = true;
+    });
+    glfwSetScrollCallback(window, [](GLFWwindow* w, double, double dy) {
+        auto* s = static_cast<ViewerState*>(glfwGetWindowUserPointer(w));
+        int width, height;
+        glfwGetWindowSize(w, &width, &height);
+        s->camera.ZoomAt(s->cursorX, s->cursorY, width, height, static_cast<float>(std::pow(1.2, dy)));
+        s->redraw = true;
+    });
+    glfwSetMouseButtonCallback(window, [](GLFWwindow* w, int button, int action, int) {
+        auto* s = static_cast<ViewerState*>(glfwGetWindowUserPointer(w));
+        if (button != GLFW_MOUSE_BUTTON_LEFT) return;
+        s->dragging = action == GLFW_PRESS;
+        if (action == GLFW_PRESS) {
+            s->pressX = s->cursorX;
+            s->pressY = s->cursorY;
+        } else if (std::abs(s->cursorX - s->pressX) <= ClickSlop && std::abs(s->cursorY - s->pressY) <= ClickSlop) {
+            s->click = true;
+        }
+    });
+    glfwSetCursorPosCallback(window, [](GLFWwindow* w, double x, double y) {
+        auto* s = static_cast<ViewerState*>(glfwGetWindowUserPointer(w));
+        if (s->dragging) {
+            int width, height;
+            glfwGetWindowSize(w, &width, &height);
+            s->camera.Pan(x - s->cursorX, y - s->cursorY, width, height);
+            s->redraw = true;
+        } else {
+            s->hover = true;
+        }
+        s->cursorX = x;
+        s->cursorY = y;
+    });
+
+    const GlExt gl = GlExt::Load();
+    FrameCapture capture(gl, options.screenshot);
+    const double minInterval = options.maxFps > 0.0 ? 1.0 / options.maxFps : 0.0;
+    double lastFrame = -minInterval;
+    while (!glfwWindowShouldClose(window)) {
+        if (signal && signal->Consume()) state.redraw = true;
+        if (state.hover || state.click) {
+            int width, height;
+            glfwGetWindowSize(window, &width, &height);
+            if (width > 0 && height > 0) {
+                float x, y;
+                state.camera.ToWorld(state.cursorX, state.cursorY, width, height, x, y);
+                const float radius = PickRadiusPixels * 2.0f / (static_cast<float>(height) * state.camera.zoom);
+                if (state.hover && scene.Hover(x, y, radius)) state.redraw = true;
+                if (state.click && scene.Select(x, y, radius)) state.redraw = true;
+            }
+            state.hover = state.click = false;
+        }
+        if (state.capture) state.redraw = true;
+
+        const double now = glfwGetTime();
+        const bool due = now - lastFrame >= minInterval;
+        if (state.redraw && due) {
+            state.redraw = false;
+            glViewport(0, 0, state.width, state.height);
+            glClear(GL_COLOR_BUFFER_BIT);
+            scene.Draw(gl, state.width, state.height, state.camera);
+            if (state.capture) {
+                state.capture = false;
+                capture.Request();
+            }
+            capture.AfterRender(state.width, state.height);
+            glfwSwapBuffers(window);
+            lastFrame = now;
+        }
+        capture.Poll();
+
+        if (state.redraw) {
+            glfwWaitEventsTimeout(lastFrame + minInterval - now); // кадр ограничен частотой: ждать до его времени
+        } else if (capture.Pending()) {
+            glfwWaitEventsTimeout(0.005);                         // заглядывать, готово ли чтение снимка
+        } else {
+            glfwWaitEvents();
+        }
+    }
+    scene.Release();
+    capture.Close();
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
+
+#endif //AUTOLABA_VIEWER_H
@@ -1,6 +1,8 @@
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <limits>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -8,8 +10,17 @@
 #include "Rules.h"
 #include "HasseBuilder.h"
 #include "Input.h"
+#include "ElementFile.h"
+#include "Graph.h"
+#include "GraphFile.h"
+#include "Layering.h"
+#include "PosetStats.h"
+#include "Export.h"
+#include "Svg.h"
 #include "Draw.h"
 #include "AminoAcids.h"
+#include "Alignment.h"
+#include "Batch.h"
 
 // отдельно выводить вершины, которые ни с чем не связаны - СДЕЛАНО!!!
 // масштабирование вершин при увеличении их количества - СДЕЛАНО!!!
@@ -47,13 +58,27 @@ static int ReadInputSourceFromUser() {
     std::cout << "Input source:\n"
                  "1 - Console\n"
                  "2 - File\n"
+                 "3 - Binary element file (.hse)\n"
                  "> ";
     int src = 0;
     if (!(std::cin >> src)) throw std::runtime_error("Bad source input");
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-    if (src != 1 && src != 2) throw std::runtime_error("Source must be 1 or 2");
+    if (src != 1 && src != 2 && src != 3) throw std::runtime_error("Source must be 1, 2 or 3");
     return src;
 }
+static std::string ReadPathFromUser(const char* prompt = "Enter file path: ") {
+    std::cout << prompt;
+    std::string path;
+    std::getline(std::cin, path);
+    return path;
+}
+static ElementFile OpenElementFile(InputMode mode, const std::string& path) {
+    ElementFile file(path);
+    if (file.Type() != ModeToElementType(mode)) {
+        throw std::runtime_error("Element file type does not match chosen type: " + path);
+    }
+    return file;
+}
 static std::vector<Element> ReadElements(InputMode mode, int src) {
     if (src == 1) {
         std::cout << "Enter elements, one per line. Empty line finishes.\n";
@@ -61,32 +86,46 @@ static std::vector<Element> ReadElements(InputMode mode, int src) {
     }
 
     // src == 2
-    std::cout << "Enter file path: ";
-    std::string path;
-    std::getline(std::cin, path);
-
+    std::string path = ReadPathFromUser();
     std::ifstream fin(path);
     if (!fin) throw std::runtime_error("Cannot open file: " + path);
 
     return ReadElementsFromLines(fin, mode);
 }
-static std::vector<Element> DeduplicateStable(const std::vector<Element>& in, int& removed) {
-    removed = 0;
-    std::vector<Element> out;
-    out.reserve(in.size());
-
-    for (const auto& e : in) {
-        bool seen = false;
-        for (const auto& x : out) {
-            if (x == e) {
-                seen = true;
-                break;
+// элементы без повторов: консоль и текстовый файл разбираются в elements, бинарный файл остается отображенным
+// в binary и не разбирается; дальше к элементам обращаются через возвращенный список
+static ElementList LoadElements(InputMode mode, int src, std::optional<ElementFile>& binary, std::vector<Element>& elements) {
+    int removed = 0;
+    if (src == 3) {
+        binary.emplace(OpenElementFile(mode, ReadPathFromUser()));
+        removed = binary->DeduplicateStable();
+    } else {
+        elements = ReadElements(mode, src);
+        const Element::Type expected = ModeToElementType(mode);
+        for (const auto& e : elements) {
+            if (e.GetType() != expected) {
+                throw std::runtime_error("Internal error: mixed element types");
             }
         }
-        if (seen) ++removed;
-        else out.push_back(e);
+        removed = DeduplicateStable(elements);
     }
-    return out;
+    if (removed > 0) {
+        std::cout << "Removed duplicates: " << removed << "\n";
+    }
+    return binary ? ElementList(*binary) : ElementList(elements);
+}
+// построение по правилу: бинарный файл сравнивается прямо по отображенным данным
+static std::vector<HasseBuilder::Edge> BuildEdges(const std::optional<ElementFile>& binary, const std::vector<Element>& elements,
+                                                  const Rules& rules) {
+    return binary ? HasseBuilder::BuildHasseEdges(static_cast<int>(binary->Count()), binary->Comparator(rules))
+                  : HasseBuilder::BuildHasseEdges(elements, rules);
+}
+// индекс элемента с тем же значением или -1
+static int FindElement(const ElementList& elements, const ElementView& e) {
+    for (std::size_t i = 0; i < elements.size(); ++i) {
+        if (elements[i] == e) return static_cast<int>(i);
+    }
+    return -1;
 }
 static Rules ReadRuleFromUser(Element::Type mode) {
     if (mode == Element::Type::INT) {
@@ -135,50 +174,75 @@ static Rules ReadRuleFromUser(Element::Type mode) {
 
     throw std::runtime_error("Unsupported element type");
 }
-static void PrintElements(const std::vector<Element>& elements) {
+static void PrintElements(const ElementList& elements) {
     std::cout << "Elements (" << elements.size() << "):\n";
     for (size_t i = 0; i < elements.size(); ++i) {
         std::cout << "  [" << i << "] " << elements[i].ToString() << "\n";
     }
 }
 
-int main() {
+static bool AskYesNo(const char* question) {
+    std::cout << question << " (y/n)\n> ";
+    std::string answer;
+    if (!(std::cin >> answer)) throw std::runtime_error("Bad answer input");
+    return !answer.empty() && (answer[0] == 'y' || answer[0] == 'Y');
+}
+// сохранение результата: hasse.dot, бинарный hasse.hsg и (по запросу) печать ребер в консоль
+static void SaveHasse(const ElementList& elements, const std::vector<HasseBuilder::Edge>& edges,
+                      const HasseStructure& hasse) {
+    std::cout << "\nHasse edges: " << edges.size() << "\n";
+    if (AskYesNo("Print edges to console?")) {
+        for (const auto& [u, v] : edges) {
+            std::cout << elements[u].ToString() << " -> " << elements[v].ToString() << "\n";
+        }
+    }
+    const PosetStats stats = ComputePosetStats(hasse.graph, hasse.layering, hasse.Reach());
+    ExportGraph(ExportFormat::DOT, "hasse.dot", elements, edges, &stats);
+    std::cout << "Saved hasse.dot\n";
+
+    WriteGraphFile("hasse.hsg", hasse.graph, hasse.layering.level, hasse.Reach());
+    std::cout << "Saved hasse.hsg\n";
+}
+
+int main(int argc, char** argv) {
+    // с аргументами командной строки работает пакетный режим без вопросов
+    if (argc > 1) return RunBatch(argc, argv);
     try {
-        std::cout << "Choose what you want to do:\n1 - Check base HasseDiagram\n2 - See a real-world application of the HasseDiagram in Bioinformatics\n> ";
+        std::cout << "Choose what you want to do:\n1 - Check base HasseDiagram\n2 - See a real-world application of the HasseDiagram in Bioinformatics\n3 - Convert text element file to binary (.hse)\n> ";
         int res;
         std::cin >> res;
+        if (res == 3) {
+            InputMode mode = ReadModeFromUser();
+            std::string in = ReadPathFromUser("Enter text file path: ");
+            std::string out = ReadPathFromUser("Enter output .hse path: ");
+            std::ifstream fin(in);
+            if (!fin) throw std::runtime_error("Cannot open file: " + in);
+            ConvertTextToElementFile(fin, mode, out);
+            std::cout << "Saved " << out << "\n";
+            return 0;
+        }
         if (res == 1) {
             InputMode mode = ReadModeFromUser();
             int src = ReadInputSourceFromUser();
-            std::vector<Element> elements = ReadElements(mode, src);
+            std::optional<ElementFile> binary;
+            std::vector<Element> storage;
+            const ElementList elements = LoadElements(mode, src, binary, storage);
             const Element::Type expected = ModeToElementType(mode);
-            for (const auto& e : elements) {
-                if (e.GetType() != expected) {
-                    throw std::runtime_error("Internal error: mixed element types");
-                }
-            }
-            int removed = 0;
-            elements = DeduplicateStable(elements, removed);
-            if (removed > 0) {
-                std::cout << "Removed duplicates: " << removed << "\n";
-            }
             PrintElements(elements);
             std::cout << "Choose how you will make pairs:\n1 - By rule\n2 - Just by pairs\n";
             int res1;
             std::cin >> res1;
             if (res1 == 1) {
                 Rules rules = ReadRuleFromUser(expected);
-                const auto edges = HasseBuilder::BuildHasseEdges(elements, rules);
+                const auto edges = BuildEdges(binary, storage, rules);
 
-                std::cout << "\nHasse edges (" << edges.size() << "):\n";
-                for (const auto& [u, v] : edges) {
-                    std::cout << elements[u].ToString() << " -> " << elements[v].ToString() << "\n";
-                }
-                std::ofstream("hasse.dot") << HasseBuilder::ToDot(elements, edges);
-                std::cout << "Saved hasse.dot\n";
-                std::vector<DrawVertex> vertices = VerticesFromHasse(elements, edges);
+                const HasseStructure hasse = HasseStructure::FromEdges(static_cast<int>(elements.size()), edges);
+                SaveHasse(elements, edges, hasse);
+                std::vector<DrawVertex> vertices = LayoutHasse(elements, hasse.graph, hasse.layering, {HardwareThreads()});
+                WriteSvg("hasse.svg", vertices, edges, Radius);
+                std::cout << "Saved hasse.svg\n";
                 std::cout << "HasseDiagram was saved in screenshot.png\n";
-                DrawHasse(vertices, edges);
+                DrawHasse(vertices, edges, hasse.graph, hasse.Reach());
             } else {
                 std::cout << "Number of pairs: ";
                 int number;
@@ -190,11 +254,9 @@ int main() {
                     if (mode == InputMode::INT) {
                         int a1, a2;
                         std::cin >> a1 >> a2;
-                        auto find1 = std::find(elements.begin(), elements.end(), a1);
-                        auto find2 = std::find(elements.begin(), elements.end(), a2);
-                        if (find1 != elements.end() && find2 != elements.end()) {
-                            int index1 = static_cast<int>(std::distance(elements.begin(), find1));
-                            int index2 = static_cast<int>(std::distance(elements.begin(), find2));
+                        const int index1 = FindElement(elements, ElementView::OfInt(a1));
+                        const int index2 = FindElement(elements, ElementView::OfInt(a2));
+                        if (index1 >= 0 && index2 >= 0) {
                             edges.emplace_back(index1, index2);
                         } else {
                             throw std::runtime_error("This element wasn't before");
@@ -202,11 +264,9 @@ int main() {
                     } else if (mode == InputMode::STRING) {
                         std::string a1, a2;
                         std::cin >> a1 >> a2;
-                        auto find1 = std::find(elements.begin(), elements.end(), a1);
-                        auto find2 = std::find(elements.begin(), elements.end(), a2);
-                        if (find1 != elements.end() && find2 != elements.end()) {
-                            int index1 = static_cast<int>(std::distance(elements.begin(), find1));
-                            int index2 = static_cast<int>(std::distance(elements.begin(), find2));
+                        const int index1 = FindElement(elements, ElementView::OfString(a1));
+                        const int index2 = FindElement(elements, ElementView::OfString(a2));
+                        if (index1 >= 0 && index2 >= 0) {
                             edges.emplace_back(index1, index2);
                         } else {
                             throw std::runtime_error("This element wasn't before");
@@ -225,66 +285,53 @@ int main() {
                             if (!v.empty())
                                 result.push_back(v);
                         }
-                        std::vector<int> a1 = result[0];
-                        std::vector<int> a2 = result[1];
-                        auto find1 = std::find(elements.begin(), elements.end(), a1);
-                        auto find2 = std::find(elements.begin(), elements.end(), a2);
-                        if (find1 != elements.end() && find2 != elements.end()) {
-                            int index1 = static_cast<int>(std::distance(elements.begin(), find1));
-                            int index2 = static_cast<int>(std::distance(elements.begin(), find2));
+                        // Element упорядочивает множество и убирает повторы, как при вводе элементов
+                        const Element a1(result[0]);
+                        const Element a2(result[1]);
+                        const int index1 = FindElement(elements, a1);
+                        const int index2 = FindElement(elements, a2);
+                        if (index1 >= 0 && index2 >= 0) {
                             edges.emplace_back(index1, index2);
                         } else {
                             throw std::runtime_error("This element wasn't before");
                         }
                     }
                 }
-                std::cout << "\nHasse edges (" << edges.size() << "):\n";
-                for (const auto& [u, v] : edges) {
-                    std::cout << elements[u].ToString() << " -> " << elements[v].ToString() << "\n";
-                }
-                std::ofstream("hasse.dot") << HasseBuilder::ToDot(elements, edges);
-                std::cout << "Saved hasse.dot\n";
-                std::vector<DrawVertex> vertices = VerticesFromHasse(elements, edges);
+                // пара, введенная дважды, - одно ребро, как и в графе
+                std::sort(edges.begin(), edges.end());
+                edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+                const HasseStructure hasse = HasseStructure::FromEdges(static_cast<int>(elements.size()), edges);
+                SaveHasse(elements, edges, hasse);
+                std::vector<DrawVertex> vertices = LayoutHasse(elements, hasse.graph, hasse.layering, {HardwareThreads()});
+                WriteSvg("hasse.svg", vertices, edges, Radius);
+                std::cout << "Saved hasse.svg\n";
                 std::cout << "HasseDiagram was saved in screenshot.png\n";
-                DrawHasse(vertices, edges);
+                DrawHasse(vertices, edges, hasse.graph, hasse.Reach());
             }
             return 0;
         } else {
-            readCSV();
             InputMode mode = InputMode::STRING;
             int src = ReadInputSourceFromUser();
-            std::vector<Element> elements = ReadElements(mode, src);
-            const Element::Type expected = ModeToElementType(mode);
-            for (const auto& e : elements) {
-                if (e.GetType() != expected) {
-                    throw std::runtime_error("Internal error: mixed element types");
-                }
-            }
-            int removed = 0;
-            elements = DeduplicateStable(elements, removed);
-            if (removed > 0) {
-                std::cout << "Removed duplicates: " << removed << "\n";
-            }
-            std::vector<Element> RealElements;
-            for (const auto & element : elements) {
-                if (CheckSeq(element.AsString())) {
-                    RealElements.push_back(element);
-                } else {
-                    throw std::runtime_error(std::format("String data '{}' is not a sequence of aminoacids", element.AsString()));
+            std::optional<ElementFile> binary;
+            std::vector<Element> storage;
+            const ElementList elements = LoadElements(mode, src, binary, storage);
+            for (std::size_t i = 0; i < elements.size(); ++i) {
+                if (!CheckSeq(elements[i].string)) {
+                    throw std::runtime_error(std::format("String data '{}' is not a sequence of aminoacids", elements[i].string));
                 }
             }
-            PrintElements(RealElements);
+            PrintElements(elements);
             Rules rules = Rules::ForString(Rules::StringRule::SUBSEQ);
-            const auto edges = HasseBuilder::BuildHasseEdges(elements, rules);
-            std::cout << "\nHasse edges (" << edges.size() << "):\n";
-            for (const auto& [u, v] : edges) {
-                std::cout << elements[u].ToString() << " -> " << elements[v].ToString() << "\n";
-            }
-            std::ofstream("hasse.dot") << HasseBuilder::ToDot(elements, edges);
-            std::cout << "Saved hasse.dot\n";
-            std::vector<DrawVertex> vertices = VerticesFromHasse(elements, edges);
+            const auto edges = BuildEdges(binary, storage, rules);
+            const HasseStructure hasse = HasseStructure::FromEdges(static_cast<int>(elements.size()), edges);
+            SaveHasse(elements, edges, hasse);
+            std::vector<DrawVertex> vertices = LayoutHasse(elements, hasse.graph, hasse.layering, {HardwareThreads()});
+            // выравнивания всех ребер считаются один раз и используются и в svg, и в окне
+            const std::vector<EdgeAlignment> alignments = AlignEdges(elements, edges, HardwareThreads());
+            WriteSvg("hasse.svg", vertices, edges, Radius, AlignmentScores(alignments));
+            std::cout << "Saved hasse.svg\n";
             std::cout << "HasseDiagram was saved in screenshot.png\n";
-            DrawHasseBio(vertices, edges);
+            DrawHasseBio(vertices, edges, hasse.graph, hasse.Reach(), alignments);
             return 0;
         }
 